@@ -0,0 +1,167 @@
+// Micro-benchmarks des chemins natifs sans N-API (parseur VT, validation
+// UTF-8, historique, pool de blocs, statistiques). Résultat en JSON sur
+// stdout, consommé par bench/run.js.
+//
+//   nebula_bench [--seconds N] [--filter nom]
+#include "io/buffer_pool.h"
+#include "io/scrollback.h"
+#include "stats.h"
+#include "vt/emulator.h"
+#include "vt/framing.h"
+#include "vt/utf8.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+    std::string name;
+    std::string unit;
+    double value;
+    uint64_t iterations;
+};
+
+double g_seconds = 0.5;
+std::string g_filter;
+std::vector<Result> g_results;
+
+// Sortie type d'un terminal : texte, couleurs SGR, déplacements, UTF-8
+std::string MakeCorpus(size_t size) {
+    static const char *const kPieces[] = {
+        "drwxr-xr-x  2 user user  4096 Jan  1 12:00 ",
+        "\x1b[1;34mdirectory\x1b[0m\r\n",
+        "\x1b[38;5;208mwarning:\x1b[39m unused variable \xe2\x80\x98x\xe2\x80\x99\r\n",
+        "\x1b[2K\x1b[1G[=====>      ] 42%",
+        "\x1b[38;2;10;200;30mok\x1b[m caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\r\n",
+        "plain ascii output line with some words in it\r\n",
+    };
+    std::string corpus;
+    corpus.reserve(size + 128);
+    size_t i = 0;
+    while (corpus.size() < size) {
+        corpus += kPieces[i++ % (sizeof(kPieces) / sizeof(kPieces[0]))];
+    }
+    corpus.resize(size);
+    // Ne pas finir au milieu d'un caractère ou d'une séquence
+    corpus.resize(size - vt::IncompleteTail(corpus.data(), corpus.size()));
+    return corpus;
+}
+
+// Répète op (qui traite bytesPerOp octets) pendant g_seconds
+void Run(const std::string &name, size_t bytesPerOp, const std::function<void()> &op) {
+    if (!g_filter.empty() && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+
+    // Échauffement : caches, allocations paresseuses
+    op();
+
+    uint64_t iterations = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(g_seconds));
+    Clock::time_point now;
+    do {
+        for (int i = 0; i < 16; i++) {
+            op();
+        }
+        iterations += 16;
+        now = Clock::now();
+    } while (now < deadline);
+
+    double elapsed = std::chrono::duration<double>(now - start).count();
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    if (bytesPerOp > 0) {
+        result.unit = "MB/s";
+        result.value = static_cast<double>(bytesPerOp) * iterations / elapsed / 1e6;
+    } else {
+        result.unit = "ns/op";
+        result.value = elapsed * 1e9 / iterations;
+    }
+    g_results.push_back(result);
+}
+
+void PrintJson() {
+    printf("{\n  \"suite\": \"native\",\n  \"seconds\": %g,\n  \"results\": [", g_seconds);
+    for (size_t i = 0; i < g_results.size(); i++) {
+        const Result &r = g_results[i];
+        printf("%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.3f, \"iterations\": %llu}",
+               i ? "," : "", r.name.c_str(), r.unit.c_str(), r.value,
+               static_cast<unsigned long long>(r.iterations));
+    }
+    printf("\n  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            g_seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            g_filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--seconds N] [--filter name]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const size_t kChunk = 64 * 1024;
+    std::string corpus = MakeCorpus(kChunk);
+    std::string ascii(kChunk, 'a');
+
+    vt::Emulator emulator(120, 30);
+    Run("vt.feed", corpus.size(), [&]() {
+        emulator.Feed(corpus.data(), corpus.size());
+    });
+
+    std::string frame;
+    Run("vt.feed+frame", corpus.size(), [&]() {
+        emulator.Feed(corpus.data(), corpus.size());
+        emulator.TakeFrame(&frame);
+    });
+
+    volatile bool sink = false;
+    Run("utf8.validate.ascii", ascii.size(), [&]() {
+        sink = vt::ValidateUtf8(ascii.data(), ascii.size()).valid;
+    });
+    Run("utf8.validate.mixed", corpus.size(), [&]() {
+        sink = vt::ValidateUtf8(corpus.data(), corpus.size()).valid;
+    });
+
+    volatile size_t tail = 0;
+    Run("framing.tail", 0, [&]() {
+        tail = vt::IncompleteTail(corpus.data(), corpus.size());
+    });
+
+    io::Scrollback scrollback(1024 * 1024);
+    Run("scrollback.append", corpus.size(), [&]() {
+        scrollback.Append(corpus.data(), corpus.size());
+    });
+
+    io::BufferPool &pool = io::BufferPool::Instance();
+    Run("pool.acquire+release", 0, [&]() {
+        pool.Release(pool.Acquire(kChunk));
+    });
+
+    stats::TerminalCounters counters;
+    uint64_t sample = 0;
+    Run("stats.record", 0, [&]() {
+        stats::Bump(counters.bytesRead, 4096);
+        counters.latency.Record(++sample & 0xffff);
+    });
+
+    (void)sink;
+    (void)tail;
+    PrintJson();
+    return 0;
+}
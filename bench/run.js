@@ -0,0 +1,418 @@
+#!/usr/bin/env node
+// Banc de mesure de l'addon, sans affichage (Linux). Chaque mesure produit
+// une ligne { suite, name, value, unit, better } ; le tout sort en JSON pour
+// être comparé d'une version à l'autre.
+//
+//   node bench/run.js [--suites throughput,echo,open,scale,loopback,native]
+//                     [--out result.json] [--baseline old.json] [--tolerance 0.1]
+//                     [--throughput-mb 64] [--echo-samples 200] [--open-samples 10]
+//                     [--scale 1,10,100,1000,2000,5000] [--idle-ms 2000]
+//                     [--loopback-mb 256] [--fuzz-mb 64] [--seed 1]
+//
+// Lancer node avec --expose-gc rend les mesures mémoire plus stables.
+// La suite native demande un build avec NEBULA_BENCH=1 (npm run bench:native).
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { execFileSync } = require('child_process');
+const { WebTerminal, getGlobalStats } = require('..');
+
+const DONE_MARKER = '__NEBULA_BENCH_DONE__';
+
+function parseArgs(argv) {
+    const options = {
+        suites: ['throughput', 'echo', 'open', 'scale', 'loopback', 'native'],
+        out: null,
+        baseline: null,
+        tolerance: 0.1,
+        throughputMb: 64,
+        echoSamples: 200,
+        openSamples: 10,
+        scale: [1, 10, 100, 1000, 2000, 5000],
+        idleMs: 2000,
+        loopbackMb: 256,
+        fuzzMb: 64,
+        seed: 1
+    };
+    for (let i = 2; i < argv.length; i++) {
+        const value = argv[i + 1];
+        switch (argv[i]) {
+        case '--suites': options.suites = value.split(','); i++; break;
+        case '--out': options.out = value; i++; break;
+        case '--baseline': options.baseline = value; i++; break;
+        case '--tolerance': options.tolerance = Number(value); i++; break;
+        case '--throughput-mb': options.throughputMb = Number(value); i++; break;
+        case '--echo-samples': options.echoSamples = Number(value); i++; break;
+        case '--open-samples': options.openSamples = Number(value); i++; break;
+        case '--scale': options.scale = value.split(',').map(Number); i++; break;
+        case '--idle-ms': options.idleMs = Number(value); i++; break;
+        case '--loopback-mb': options.loopbackMb = Number(value); i++; break;
+        case '--fuzz-mb': options.fuzzMb = Number(value); i++; break;
+        case '--seed': options.seed = Number(value); i++; break;
+        default:
+            console.error('Unknown option: ' + argv[i]);
+            process.exit(2);
+        }
+    }
+    return options;
+}
+
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms));
+const nowMs = () => Number(process.hrtime.bigint()) / 1e6;
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) return 0;
+    const index = Math.min(sorted.length - 1, Math.ceil(p / 100 * sorted.length) - 1);
+    return sorted[Math.max(0, index)];
+}
+
+// Percentile approché depuis l'histogramme cumulatif de getStats()
+function histogramPercentile(latency, p) {
+    const target = latency.count * p / 100;
+    for (const bucket of latency.buckets) {
+        if (bucket.count >= target) return bucket.le;
+    }
+    return Infinity;
+}
+
+function collectGc() {
+    if (global.gc) {
+        global.gc();
+        global.gc();
+    }
+}
+
+// Terminal démarré sur /bin/sh avec un prompt connu, prêt à recevoir des commandes
+async function openTerminal(onData) {
+    const term = new WebTerminal();
+    const session = { term, output: '', listeners: [] };
+    term.onData((data) => {
+        const text = data.toString('latin1');
+        if (onData) onData(data);
+        session.output = (session.output + text).slice(-256);
+        for (const listener of session.listeners.slice()) listener(text);
+    });
+    // La promesse est réglée une fois le shell lancé
+    await term.startProcess({ cols: 120, rows: 30 });
+    return session;
+}
+
+function waitFor(session, predicate, timeoutMs) {
+    return new Promise((resolve, reject) => {
+        if (predicate(session.output)) return resolve();
+        const timer = setTimeout(() => {
+            remove();
+            reject(new Error('Timed out waiting for terminal output'));
+        }, timeoutMs);
+        const listener = () => {
+            if (predicate(session.output)) {
+                remove();
+                resolve();
+            }
+        };
+        const remove = () => {
+            clearTimeout(timer);
+            session.listeners.splice(session.listeners.indexOf(listener), 1);
+        };
+        session.listeners.push(listener);
+    });
+}
+
+function closeTerminal(session) {
+    try {
+        session.term.write('exit\r');
+    } catch (error) {
+        // Déjà fermé
+    }
+    session.listeners.length = 0;
+}
+
+function makeFile(megabytes) {
+    const file = path.join(os.tmpdir(), `nebula-bench-${process.pid}.txt`);
+    const line = 'The quick brown fox jumps over the lazy dog 0123456789 ~!@#$%^&*()_+\n';
+    const block = line.repeat(Math.ceil(1024 * 1024 / line.length)).slice(0, 1024 * 1024);
+    const fd = fs.openSync(file, 'w');
+    for (let i = 0; i < megabytes; i++) fs.writeSync(fd, block);
+    fs.closeSync(fd);
+    return file;
+}
+
+async function benchThroughput(options, report) {
+    const file = makeFile(options.throughputMb);
+    let received = 0;
+    const session = await openTerminal((data) => { received += data.length; });
+    try {
+        await sleep(200);
+        // Le marqueur est recollé par le shell : l'écho de la commande ne le contient pas
+        const half = DONE_MARKER.length >> 1;
+        const command = `cat '${file}'; printf '%s%s\\n' '${DONE_MARKER.slice(0, half)}' '${DONE_MARKER.slice(half)}'\r`;
+
+        const cpuStart = process.cpuUsage();
+        const start = nowMs();
+        received = 0;
+        session.term.write(command);
+        await waitFor(session, (output) => output.includes(DONE_MARKER), 600000);
+        const elapsed = nowMs() - start;
+        const cpu = process.cpuUsage(cpuStart);
+
+        const stats = session.term.getStats();
+        report('throughput', 'bulk.bytes_per_sec', received / elapsed * 1000 / 1e6, 'MB/s', 'higher');
+        report('throughput', 'bulk.elapsed', elapsed, 'ms', 'lower');
+        report('throughput', 'bulk.cpu', (cpu.user + cpu.system) / 1000 / elapsed * 100, '%', 'lower');
+        report('throughput', 'bulk.callbacks', stats.callbacks, 'count', 'lower');
+        report('throughput', 'bulk.read_calls', stats.readCalls, 'count', 'lower');
+        report('throughput', 'bulk.peak_queue_depth', stats.peakQueueDepth, 'blocks', 'lower');
+        report('throughput', 'bulk.read_to_callback.p50', histogramPercentile(stats.latency, 50), 'us', 'lower');
+        report('throughput', 'bulk.read_to_callback.p99', histogramPercentile(stats.latency, 99), 'us', 'lower');
+    } finally {
+        closeTerminal(session);
+        fs.unlinkSync(file);
+    }
+}
+
+async function benchEcho(options, report) {
+    const session = await openTerminal();
+    try {
+        await sleep(200);
+        const samples = [];
+        for (let i = 0; i < options.echoSamples; i++) {
+            // Une frappe, puis la première sortie qui la renvoie
+            const echoed = new Promise((resolve) => {
+                const listener = () => {
+                    session.listeners.splice(session.listeners.indexOf(listener), 1);
+                    resolve(nowMs());
+                };
+                session.listeners.push(listener);
+            });
+            const start = nowMs();
+            session.term.write('x');
+            samples.push(await echoed - start);
+            if (i % 64 === 63) {
+                // Vide la ligne en cours (Ctrl-U)
+                session.term.write('\x15');
+                await sleep(20);
+            }
+            await sleep(2);
+        }
+        session.term.write('\x15');
+
+        samples.sort((a, b) => a - b);
+        for (const p of [50, 90, 99]) {
+            report('echo', `keystroke.p${p}`, percentile(samples, p), 'ms', 'lower');
+        }
+        report('echo', 'keystroke.max', samples[samples.length - 1], 'ms', 'lower');
+    } finally {
+        closeTerminal(session);
+    }
+}
+
+async function benchOpen(options, report) {
+    const started = [];
+    const prompted = [];
+    for (let i = 0; i < options.openSamples; i++) {
+        const start = nowMs();
+        const session = await openTerminal();
+        started.push(nowMs() - start);
+        await waitFor(session, (output) => output.length > 0, 10000);
+        prompted.push(nowMs() - start);
+        closeTerminal(session);
+    }
+    started.sort((a, b) => a - b);
+    prompted.sort((a, b) => a - b);
+    report('open', 'start_process.p50', percentile(started, 50), 'ms', 'lower');
+    report('open', 'start_process.max', started[started.length - 1], 'ms', 'lower');
+    report('open', 'first_output.p50', percentile(prompted, 50), 'ms', 'lower');
+    report('open', 'first_output.max', prompted[prompted.length - 1], 'ms', 'lower');
+}
+
+async function benchScale(options, report) {
+    for (const count of options.scale) {
+        collectGc();
+        const before = process.memoryUsage();
+        const sessions = [];
+        const start = nowMs();
+        let error = null;
+        try {
+            for (let i = 0; i < count; i++) {
+                sessions.push(await openTerminal());
+            }
+        } catch (e) {
+            error = e;
+        }
+        const openMs = nowMs() - start;
+
+        // Terminaux ouverts et muets : ce qu'ils coûtent au repos
+        await sleep(200);
+        const cpuStart = process.cpuUsage();
+        await sleep(options.idleMs);
+        const cpu = process.cpuUsage(cpuStart);
+        collectGc();
+        const after = process.memoryUsage();
+
+        const opened = sessions.length;
+        const prefix = `terminals_${count}`;
+        report('scale', `${prefix}.opened`, opened, 'count', 'higher');
+        report('scale', `${prefix}.open_time`, openMs, 'ms', 'lower');
+        report('scale', `${prefix}.rss_per_terminal`, opened ? (after.rss - before.rss) / opened / 1024 : 0, 'KiB', 'lower');
+        report('scale', `${prefix}.heap_per_terminal`, opened ? (after.heapUsed - before.heapUsed) / opened / 1024 : 0, 'KiB', 'lower');
+        report('scale', `${prefix}.idle_cpu`, (cpu.user + cpu.system) / 1000 / options.idleMs * 100, '%', 'lower');
+        report('scale', `${prefix}.threads`, threadCount(), 'count', 'lower');
+        if (error) {
+            console.error(`scale ${count}: stopped after ${opened} terminals: ${error.message}`);
+        }
+
+        for (const session of sessions) closeTerminal(session);
+        await sleep(500);
+        if (error) break;
+    }
+}
+
+function threadCount() {
+    try {
+        return fs.readdirSync('/proc/self/task').length;
+    } catch (error) {
+        return 0;
+    }
+}
+
+// Sortie du backend loopback jusqu'à sa fin : { bytes, elapsed, cpu, code, stats }
+async function runLoopback(terminalOptions, loopback, timeoutMs) {
+    const term = new WebTerminal(terminalOptions);
+    let bytes = 0;
+    term.onData((data) => { bytes += data.length; });
+    const exited = new Promise((resolve, reject) => {
+        const timer = setTimeout(() => reject(new Error('Loopback session did not finish')), timeoutMs);
+        term.onExit((code) => {
+            clearTimeout(timer);
+            resolve(code);
+        });
+    });
+    const cpuStart = process.cpuUsage();
+    const start = nowMs();
+    await term.startProcess({ cols: 120, rows: 30, loopback });
+    const code = await exited;
+    const elapsed = nowMs() - start;
+    const cpu = process.cpuUsage(cpuStart);
+    return { bytes, elapsed, cpu: (cpu.user + cpu.system) / 1000 / elapsed * 100, code, stats: term.getStats() };
+}
+
+// Sans processus ni shell : débit du chemin ReadLoop → TSFN → onData, et
+// robustesse de l'analyseur VT face à un flux hostile reproductible
+async function benchLoopback(options, report) {
+    const total = options.loopbackMb * 1024 * 1024;
+    const raw = await runLoopback({}, { source: 'ansi', bytes: total, seed: options.seed }, 600000);
+    if (raw.bytes !== total) {
+        throw new Error(`Loopback delivered ${raw.bytes} of ${total} bytes`);
+    }
+    report('loopback', 'raw.bytes_per_sec', raw.bytes / raw.elapsed * 1000 / 1e6, 'MB/s', 'higher');
+    report('loopback', 'raw.cpu', raw.cpu, '%', 'lower');
+    report('loopback', 'raw.callbacks', raw.stats.callbacks, 'count', 'lower');
+    report('loopback', 'raw.read_to_callback.p99', histogramPercentile(raw.stats.latency, 99), 'us', 'lower');
+
+    const screen = await runLoopback({ screen: true }, { source: 'ansi', bytes: total, seed: options.seed }, 600000);
+    report('loopback', 'screen.bytes_per_sec', screen.bytes / screen.elapsed * 1000 / 1e6, 'MB/s', 'higher');
+    report('loopback', 'screen.cpu', screen.cpu, '%', 'lower');
+
+    // Le code de sortie prouve que la session est allée au bout sans planter
+    const fuzzTotal = options.fuzzMb * 1024 * 1024;
+    const fuzz = await runLoopback({ screen: true },
+        { source: 'fuzz', bytes: fuzzTotal, seed: options.seed, exitCode: 42 }, 600000);
+    if (fuzz.code !== 42 || fuzz.bytes !== fuzzTotal) {
+        throw new Error(`Fuzz session ended with code ${fuzz.code} after ${fuzz.bytes} bytes`);
+    }
+    report('loopback', 'fuzz.bytes_per_sec', fuzz.bytes / fuzz.elapsed * 1000 / 1e6, 'MB/s', 'higher');
+}
+
+function benchNative(options, report) {
+    const binary = path.join(__dirname, '..', 'build', 'Release', 'nebula_bench');
+    if (!fs.existsSync(binary)) {
+        console.error('native suite skipped: build it with `npm run bench:native`');
+        return;
+    }
+    const output = JSON.parse(execFileSync(binary, ['--seconds', '1'], { encoding: 'utf8' }));
+    for (const result of output.results) {
+        report('native', result.name, result.value, result.unit, result.unit === 'MB/s' ? 'higher' : 'lower');
+    }
+}
+
+// Régressions au-delà de la tolérance par rapport à un résultat précédent
+function compare(results, baselineFile, tolerance) {
+    const baseline = JSON.parse(fs.readFileSync(baselineFile, 'utf8'));
+    const previous = new Map(baseline.results.map((r) => [`${r.suite}/${r.name}`, r]));
+    const regressions = [];
+    for (const result of results) {
+        const old = previous.get(`${result.suite}/${result.name}`);
+        if (!old || !old.value || !isFinite(old.value) || !isFinite(result.value)) continue;
+        const change = (result.value - old.value) / Math.abs(old.value);
+        const worse = result.better === 'higher' ? -change : change;
+        if (worse > tolerance) {
+            regressions.push({ suite: result.suite, name: result.name, before: old.value, after: result.value, change });
+        }
+    }
+    return regressions;
+}
+
+async function main() {
+    const options = parseArgs(process.argv);
+    // Shell prévisible d'une machine à l'autre
+    process.env.SHELL = '/bin/sh';
+    process.env.PS1 = '$ ';
+
+    const results = [];
+    const report = (suite, name, value, unit, better) => {
+        results.push({ suite, name, value: Math.round(value * 1000) / 1000, unit, better });
+        console.error(`${suite.padEnd(10)} ${name.padEnd(40)} ${value.toFixed(3)} ${unit}`);
+    };
+
+    const suites = {
+        throughput: benchThroughput,
+        echo: benchEcho,
+        open: benchOpen,
+        scale: benchScale,
+        loopback: benchLoopback,
+        native: benchNative
+    };
+    for (const name of options.suites) {
+        if (!suites[name]) {
+            console.error('Unknown suite: ' + name);
+            process.exit(2);
+        }
+        await suites[name](options, report);
+    }
+
+    const aggregate = getGlobalStats();
+    const document = {
+        version: require('../package.json').version,
+        date: new Date().toISOString(),
+        node: process.version,
+        platform: `${os.platform()} ${os.release()} ${os.arch()}`,
+        cpus: os.cpus().length,
+        cpuModel: os.cpus()[0] ? os.cpus()[0].model : '',
+        totals: { terminalsCreated: aggregate.terminalsCreated, bytesRead: aggregate.bytesRead },
+        results
+    };
+
+    let exitCode = 0;
+    if (options.baseline) {
+        document.regressions = compare(results, options.baseline, options.tolerance);
+        for (const r of document.regressions) {
+            console.error(`REGRESSION ${r.suite}/${r.name}: ${r.before} -> ${r.after} (${(r.change * 100).toFixed(1)}%)`);
+        }
+        exitCode = document.regressions.length > 0 ? 1 : 0;
+    }
+
+    const json = JSON.stringify(document, null, 2) + '\n';
+    if (options.out) {
+        fs.writeFileSync(options.out, json);
+    } else {
+        process.stdout.write(json);
+    }
+    // Les shells restants et les threads natifs ne doivent pas retarder la sortie
+    process.exit(exitCode);
+}
+
+main().catch((error) => {
+    console.error(error);
+    process.exit(1);
+});
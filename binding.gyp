@@ -1,4 +1,7 @@
 {
+  "variables": {
+    "nebula_bench%": "<!(node -p \"process.env.NEBULA_BENCH || 0\")"
+  },
   "targets": [{
     "target_name": "terminal",
     "include_dirs": [
@@ -7,15 +10,59 @@
     ],
     "sources": [
       "src/terminal.cc",
-      "src/win/conpty.cc"
+      "src/pty_backend.cc",
+      "src/pty_pool.cc",
+      "src/pty_handoff.cc",
+      "src/stats.cc",
+      "src/Logger/logger.cc",
+      "src/io/buffer_pool.cc",
+      "src/io/frame_encoder.cc",
+      "src/io/reactor.cc",
+      "src/io/recorder.cc",
+      "src/io/scrollback.cc",
+      "src/io/shared_ring.cc",
+      "src/io/ticker.cc",
+      "src/io/write_queue.cc",
+      "src/loopback/generator.cc",
+      "src/loopback/loopback_pty.cc",
+      "src/vt/scan.cc",
+      "src/vt/screen.cc",
+      "src/vt/parser.cc",
+      "src/vt/snapshot.cc",
+      "src/vt/emulator.cc",
+      "src/vt/framing.cc",
+      "src/vt/triggers.cc",
+      "src/vt/utf8.cc"
     ],
-    "defines": ["NAPI_DISABLE_CPP_EXCEPTIONS"],
+    "defines": ["NAPI_CPP_EXCEPTIONS"],
+    "cflags!": ["-fno-exceptions"],
+    "cflags_cc!": ["-fno-exceptions"],
     "libraries": [],
     "conditions": [
       ["OS=='win'", {
+        "sources": [
+          "src/win/conpty.cc"
+        ],
         "libraries": [
           "-lkernel32.lib"
         ]
+      }],
+      ["OS!='win'", {
+        "sources": [
+          "src/unix/unixpty.cc",
+          "src/unix/exit_monitor.cc",
+          "src/unix/reaper.cc"
+        ]
+      }],
+      ["OS=='linux'", {
+        "libraries": [
+          "-lutil"
+        ]
+      }],
+      ["OS=='mac'", {
+        "xcode_settings": {
+          "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
+        }
       }]
     ],
     "msvs_settings": {
@@ -23,5 +70,38 @@
         "ExceptionHandling": 1
       }
     }
-  }]
-}
\ No newline at end of file
+  }],
+  "conditions": [
+    ["nebula_bench==1", {
+      "targets": [{
+        "target_name": "nebula_bench",
+        "type": "executable",
+        "include_dirs": [
+          "src"
+        ],
+        "sources": [
+          "bench/native/bench.cc",
+          "src/stats.cc",
+          "src/io/buffer_pool.cc",
+          "src/io/scrollback.cc",
+          "src/vt/scan.cc",
+          "src/vt/screen.cc",
+          "src/vt/parser.cc",
+          "src/vt/snapshot.cc",
+          "src/vt/emulator.cc",
+          "src/vt/framing.cc",
+          "src/vt/utf8.cc"
+        ],
+        "cflags!": ["-fno-exceptions"],
+        "cflags_cc!": ["-fno-exceptions"],
+        "conditions": [
+          ["OS=='mac'", {
+            "xcode_settings": {
+              "GCC_ENABLE_CPP_EXCEPTIONS": "YES"
+            }
+          }]
+        ]
+      }]
+    }]
+  ]
+}
@@ -1,5 +1,21 @@
-const { WebTerminal } = require('./build/Release/terminal.node');
+const {
+    WebTerminal,
+    getBufferPoolStats,
+    getGlobalStats,
+    configureBufferPool,
+    configureReactor,
+    configureLogger,
+    configurePtyPool,
+    getPtyPoolStats
+} = require('./build/Release/terminal.node');
 
 module.exports = {
-    WebTerminal
+    WebTerminal,
+    getBufferPoolStats,
+    getGlobalStats,
+    configureBufferPool,
+    configureReactor,
+    configureLogger,
+    configurePtyPool,
+    getPtyPoolStats
 };
\ No newline at end of file
@@ -1,61 +1,279 @@
 #include "logger.h"
-#include <iostream>
-#include <fstream>
+#include "io/mpsc_queue.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <ctime>
-#include <sstream>
+#include <mutex>
 #include <thread>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
-// Initialisation des membres statiques
-HANDLE Logger::hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-std::mutex Logger::consoleMutex;
+std::atomic<int> Logger::threshold(static_cast<int>(Logger::Level::Info));
+
+namespace {
+
+struct Entry {
+    std::atomic<Entry*> next;
+    Logger::Level level;
+    std::chrono::system_clock::time_point time;
+    std::thread::id thread;
+    std::string message;
+};
+
+// File MPSC partagée avec l'enregistreur de session
+using EntryQueue = io::MpscQueue<Entry>;
+
+// Fichier par défaut tant que configureLogger({ file }) n'a rien choisi
+const char* const kDefaultFile = "terminal.log";
+
+struct LogState {
+    EntryQueue queue;
+    std::atomic<uint64_t> pushed{0};
+    // Le thread d'écriture va s'endormir : le prochain message le réveille
+    std::atomic<bool> sleeping{false};
+
+    // Réservés au thread d'écriture et à la configuration
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    uint64_t writtenCount = 0;
+    FILE* file = nullptr;
+    bool fileConfigured = false;
+    bool console = true;
+    bool colors = false;
+    std::once_flag started;
+};
+
+LogState& State() {
+    // Jamais détruit : des threads peuvent journaliser jusqu'à la sortie
+    static LogState* state = new LogState();
+    return *state;
+}
+
+#ifndef _WIN32
+const char* ColorFor(Logger::Level level) {
+    switch (level) {
+    case Logger::Level::Debug: return "\x1b[94m";
+    case Logger::Level::Info: return "\x1b[92m";
+    case Logger::Level::Warning: return "\x1b[93m";
+    default: return "\x1b[91m";
+    }
+}
+#endif
+
+std::string Format(const Entry& entry) {
+    std::time_t now = std::chrono::system_clock::to_time_t(entry.time);
+    struct tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &now);
+#else
+    localtime_r(&now, &timeinfo);
+#endif
+    char buffer[26];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+    std::ostringstream line;
+    line << "[" << buffer << "] "
+         << "[" << Logger::LevelName(entry.level) << "] "
+         << "[Thread: " << entry.thread << "] "
+         << entry.message;
+    return line.str();
+}
+
+void WriteToConsole(LogState& state, const Entry& entry, const std::string& line) {
+#ifdef _WIN32
+    static const WORD kColors[] = {
+        FOREGROUND_INTENSITY | FOREGROUND_BLUE,
+        FOREGROUND_INTENSITY | FOREGROUND_GREEN,
+        FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN,
+        FOREGROUND_INTENSITY | FOREGROUND_RED,
+    };
+    HANDLE console = GetStdHandle(STD_ERROR_HANDLE);
+    if (state.colors) {
+        SetConsoleTextAttribute(console, kColors[static_cast<int>(entry.level)]);
+    }
+    fprintf(stderr, "%s\n", line.c_str());
+    fflush(stderr);
+    if (state.colors) {
+        SetConsoleTextAttribute(console, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+    }
+#else
+    if (state.colors) {
+        fprintf(stderr, "%s%s\x1b[0m\n", ColorFor(entry.level), line.c_str());
+    } else {
+        fprintf(stderr, "%s\n", line.c_str());
+    }
+#endif
+}
+
+void WriterLoop() {
+    LogState& state = State();
+    std::unique_lock<std::mutex> lock(state.mutex);
+
+    while (true) {
+        // Sans minuterie : on ne dort que file vide, et Log() réveille
+        state.sleeping.store(true);
+        if (state.pushed.load() == state.writtenCount) {
+            state.wake.wait(lock, [&state]() { return !state.sleeping.load(); });
+        } else {
+            state.sleeping.store(false);
+        }
+
+        uint64_t count = 0;
+        while (Entry* entry = state.queue.Pop()) {
+            std::string line = Format(*entry);
+            if (state.console) {
+                WriteToConsole(state, *entry, line);
+            }
+            if (state.file) {
+                fprintf(state.file, "%s\n", line.c_str());
+            }
+            delete entry;
+            count++;
+        }
+
+        if (count > 0) {
+            fflush(stderr);
+            if (state.file) {
+                fflush(state.file);
+            }
+            state.writtenCount += count;
+            state.written.notify_all();
+        } else {
+            // Un producteur est en train de chaîner son message
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+    }
+}
+
+void StartWriter(LogState& state) {
+    std::call_once(state.started, [&state]() {
+#ifdef _WIN32
+        state.colors = _isatty(_fileno(stderr)) != 0;
+#else
+        state.colors = isatty(fileno(stderr)) != 0;
+#endif
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.fileConfigured) {
+                state.file = fopen(kDefaultFile, "a");
+            }
+        }
+        std::thread(WriterLoop).detach();
+    });
+}
+
+} // namespace
 
 void Logger::Debug(const std::string& message) {
-    LogWithColor(message, "DEBUG", FOREGROUND_INTENSITY | FOREGROUND_BLUE);
+    Log(Level::Debug, message);
 }
 
 void Logger::Info(const std::string& message) {
-    LogWithColor(message, "INFO", FOREGROUND_INTENSITY | FOREGROUND_GREEN);
+    Log(Level::Info, message);
 }
 
 void Logger::Warning(const std::string& message) {
-    LogWithColor(message, "WARNING", FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN);
+    Log(Level::Warning, message);
 }
 
 void Logger::Error(const std::string& message) {
-    LogWithColor(message, "ERROR", FOREGROUND_INTENSITY | FOREGROUND_RED);
+    Log(Level::Error, message);
 }
 
-void Logger::LogWithColor(const std::string& message, const std::string& level, WORD color) {
-    std::time_t now = std::time(nullptr);
-    char buffer[26];
-    struct tm timeinfo;
-    localtime_s(&timeinfo, &now);
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &timeinfo);
-    
-    std::stringstream threadId;
-    threadId << std::this_thread::get_id();
-
-    std::stringstream fullMessage;
-    fullMessage << "[" << buffer << "] "
-               << "[" << level << "] "
-               << "[Thread: " << threadId.str() << "] "
-               << message;
-
-    // Log dans un fichier
-    {
-        static std::mutex fileMutex;
-        std::lock_guard<std::mutex> lock(fileMutex);
-        std::ofstream logFile("terminal.log", std::ios::app);
-        if (logFile.is_open()) {
-            logFile << fullMessage.str() << std::endl;
+void Logger::Log(Level level, const std::string& message) {
+    if (!Enabled(level)) return;
+
+    LogState& state = State();
+    StartWriter(state);
+
+    Entry* entry = new Entry();
+    entry->level = level;
+    entry->time = std::chrono::system_clock::now();
+    entry->thread = std::this_thread::get_id();
+    entry->message = message;
+    state.pushed.fetch_add(1);
+    state.queue.Push(entry);
+    if (state.sleeping.exchange(false)) {
+        // File vide jusqu'ici : seul ce cas prend le verrou
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.wake.notify_one();
+    }
+}
+
+void Logger::SetLevel(Level level) {
+    threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Logger::Level Logger::GetLevel() {
+    return static_cast<Level>(threshold.load(std::memory_order_relaxed));
+}
+
+bool Logger::SetFile(const std::string& path) {
+    FILE* file = nullptr;
+    if (!path.empty()) {
+        file = fopen(path.c_str(), "a");
+        if (!file) {
+            return false;
         }
     }
 
-    // Log dans la console avec couleur
-    {
-        std::lock_guard<std::mutex> lock(consoleMutex);
-        SetConsoleTextAttribute(hConsole, color);
-        std::cout << fullMessage.str() << std::endl;
-        SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.file) {
+        fclose(state.file);
+    }
+    state.file = file;
+    state.fileConfigured = true;
+    return true;
+}
+
+void Logger::SetConsole(bool enabled) {
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.console = enabled;
+}
+
+void Logger::Flush() {
+    LogState& state = State();
+    uint64_t target = state.pushed.load(std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (state.writtenCount < target) {
+        state.written.wait(lock);
     }
-}
\ No newline at end of file
+}
+
+bool Logger::ParseLevel(const std::string& name, Level* level) {
+    static const struct { const char* name; Level level; } kLevels[] = {
+        {"debug", Level::Debug},
+        {"info", Level::Info},
+        {"warning", Level::Warning},
+        {"error", Level::Error},
+        {"off", Level::Off},
+    };
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            *level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Logger::LevelName(Level level) {
+    switch (level) {
+    case Level::Debug: return "DEBUG";
+    case Level::Info: return "INFO";
+    case Level::Warning: return "WARNING";
+    case Level::Error: return "ERROR";
+    default: return "OFF";
+    }
+}
@@ -1,17 +1,53 @@
 #pragma once
+#include <atomic>
+#include <sstream>
 #include <string>
-#include <windows.h>
-#include <mutex>
 
+// Journal asynchrone : les appels empilent le message dans une file sans
+// verrou (plusieurs producteurs, un consommateur) et un thread de fond
+// l'écrit sur la console et dans un fichier gardé ouvert (terminal.log
+// par défaut).
 class Logger {
 public:
+    enum class Level : int { Debug = 0, Info, Warning, Error, Off };
+
     static void Debug(const std::string& message);
     static void Info(const std::string& message);
     static void Warning(const std::string& message);
     static void Error(const std::string& message);
+    static void Log(Level level, const std::string& message);
+
+    // Test d'un niveau masqué : une lecture atomique relâchée
+    static bool Enabled(Level level) {
+        return static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+    }
+
+    static void SetLevel(Level level);
+    static Level GetLevel();
+    // Chemin vide : plus de fichier. false si le fichier ne s'ouvre pas.
+    static bool SetFile(const std::string& path);
+    static void SetConsole(bool enabled);
+    // Attend que tout ce qui a été journalisé soit écrit
+    static void Flush();
+
+    static bool ParseLevel(const std::string& name, Level* level);
+    static const char* LevelName(Level level);
 
 private:
-    static void LogWithColor(const std::string& message, const std::string& level, WORD color);
-    static HANDLE hConsole;
-    static std::mutex consoleMutex;
-};
\ No newline at end of file
+    static std::atomic<int> threshold;
+};
+
+// Le message n'est construit que si le niveau est actif
+#define NEBULA_LOG(level, expr)                                  \
+    do {                                                         \
+        if (Logger::Enabled(level)) {                            \
+            std::ostringstream nebulaLogStream;                  \
+            nebulaLogStream << expr;                             \
+            Logger::Log(level, nebulaLogStream.str());           \
+        }                                                        \
+    } while (0)
+
+#define LOG_DEBUG(expr) NEBULA_LOG(Logger::Level::Debug, expr)
+#define LOG_INFO(expr) NEBULA_LOG(Logger::Level::Info, expr)
+#define LOG_WARNING(expr) NEBULA_LOG(Logger::Level::Warning, expr)
+#define LOG_ERROR(expr) NEBULA_LOG(Logger::Level::Error, expr)
@@ -0,0 +1,120 @@
+#include "io/buffer_pool.h"
+#include <new>
+
+namespace io {
+
+static uint32_t ClassCapacity(int sizeClass) {
+    return BufferPool::kMinBlockSize << (2 * sizeClass);
+}
+
+static int ClassFor(size_t minCapacity) {
+    int sizeClass = 0;
+    while (sizeClass < BufferPool::kClassCount - 1 && ClassCapacity(sizeClass) < minCapacity) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+// En-tête construit en place devant les données : refs est un vrai atomique
+static Block *NewBlock(int sizeClass) {
+    uint32_t capacity = ClassCapacity(sizeClass);
+    void *memory = ::operator new(sizeof(Block) + capacity);
+    Block *block = new (memory) Block{};
+    block->data = static_cast<char *>(memory) + sizeof(Block);
+    block->capacity = capacity;
+    block->sizeClass = static_cast<uint8_t>(sizeClass);
+    return block;
+}
+
+static void FreeBlock(Block *block) {
+    block->~Block();
+    ::operator delete(block);
+}
+
+BufferPool &BufferPool::Instance() {
+    // Jamais détruit : des Buffers peuvent être finalisés après le déchargement du module
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::BufferPool() : stats() {
+    for (int i = 0; i < kClassCount; i++) {
+        freeLists[i] = nullptr;
+    }
+    stats.maxBytesRetained = 16 * 1024 * 1024;
+}
+
+Block *BufferPool::Acquire(size_t minCapacity) {
+    int sizeClass = ClassFor(minCapacity);
+    Block *block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.acquires++;
+        block = freeLists[sizeClass];
+        if (block) {
+            freeLists[sizeClass] = block->next;
+            stats.bytesRetained -= block->capacity;
+        } else {
+            stats.misses++;
+        }
+        stats.blocksInUse++;
+        stats.bytesInUse += ClassCapacity(sizeClass);
+        if (stats.bytesInUse > stats.peakBytesInUse) {
+            stats.peakBytesInUse = stats.bytesInUse;
+        }
+    }
+
+    if (!block) {
+        // En-tête et données dans une seule allocation
+        block = NewBlock(sizeClass);
+    }
+
+    block->size = 0;
+    block->refs.store(1, std::memory_order_relaxed);
+    block->readAt = 0;
+    block->next = nullptr;
+    return block;
+}
+
+void BufferPool::Release(Block *block) {
+    if (!block) return;
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.blocksInUse--;
+    stats.bytesInUse -= block->capacity;
+
+    if (stats.bytesRetained + block->capacity > stats.maxBytesRetained) {
+        FreeBlock(block);
+        return;
+    }
+
+    block->next = freeLists[block->sizeClass];
+    freeLists[block->sizeClass] = block;
+    stats.bytesRetained += block->capacity;
+}
+
+void BufferPool::SetMaxRetained(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.maxBytesRetained = bytes;
+    Trim();
+}
+
+void BufferPool::Trim() {
+    // Libère d'abord les gros blocs
+    for (int i = kClassCount - 1; i >= 0 && stats.bytesRetained > stats.maxBytesRetained; i--) {
+        while (freeLists[i] && stats.bytesRetained > stats.maxBytesRetained) {
+            Block *block = freeLists[i];
+            freeLists[i] = block->next;
+            stats.bytesRetained -= block->capacity;
+            FreeBlock(block);
+        }
+    }
+}
+
+BufferPoolStats BufferPool::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+} // namespace io
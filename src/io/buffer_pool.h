@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+namespace io {
+
+// Bloc de sortie : la lecture du PTY s'y fait directement, puis il est
+// confié à JS comme Buffer externe et revient au pool à sa finalisation.
+// Plusieurs consommateurs (JS, enregistrement) peuvent le partager : il
+// n'est rendu qu'au dernier Release().
+struct Block {
+    char *data;
+    uint32_t size;
+    uint32_t capacity;
+    uint8_t sizeClass;
+    std::atomic<uint32_t> refs;
+    // Lecture PTY de son premier octet (ns, horloge monotone), pour les statistiques
+    int64_t readAt;
+    // Position dans le flux de sortie (offsets de Scrollback) de son premier octet
+    uint64_t offset;
+    Block *next;
+};
+
+struct BufferPoolStats {
+    uint64_t acquires;
+    uint64_t misses;
+    size_t blocksInUse;
+    size_t bytesInUse;
+    size_t peakBytesInUse;
+    size_t bytesRetained;
+    size_t maxBytesRetained;
+};
+
+class BufferPool {
+public:
+    static const int kClassCount = 5;
+    static const uint32_t kMinBlockSize = 1024;
+    static const uint32_t kMaxBlockSize = kMinBlockSize << (2 * (kClassCount - 1));
+
+    static BufferPool &Instance();
+
+    // Bloc d'au moins minCapacity octets (plafonné à kMaxBlockSize), size == 0
+    Block *Acquire(size_t minCapacity);
+    void Release(Block *block);
+    // Référence supplémentaire, à rendre par Release()
+    static void Retain(Block *block) { block->refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void SetMaxRetained(size_t bytes);
+    BufferPoolStats GetStats();
+
+private:
+    BufferPool();
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    void Trim();
+
+    std::mutex mutex;
+    Block *freeLists[kClassCount];
+    BufferPoolStats stats;
+};
+
+} // namespace io
@@ -0,0 +1,102 @@
+#include "io/frame_encoder.h"
+#include "io/buffer_pool.h"
+#include <cstring>
+#include <zlib.h>
+
+namespace io {
+
+static void PutLe(char *out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+FrameEncoder::FrameEncoder(uint32_t sessionId, int level)
+    : sessionId(sessionId),
+      level(level),
+      stream(nullptr),
+      broken(false) {
+}
+
+FrameEncoder::~FrameEncoder() {
+    if (stream) {
+        deflateEnd(stream);
+        delete stream;
+    }
+}
+
+bool FrameEncoder::Init() {
+    if (level == 0) {
+        return true;
+    }
+    stream = new z_stream();
+    // windowBits négatif : deflate brut, sans en-tête zlib ni somme de contrôle
+    if (deflateInit2(stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete stream;
+        stream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+Block *FrameEncoder::Encode(const char *data, size_t size, uint64_t offset) {
+    Block *frame;
+    if (stream) {
+        frame = Deflate(data, size);
+        if (!frame) {
+            return nullptr;
+        }
+    } else {
+        frame = BufferPool::Instance().Acquire(kHeaderBytes + size);
+        std::memcpy(frame->data + kHeaderBytes, data, size);
+        frame->size = static_cast<uint32_t>(kHeaderBytes + size);
+    }
+
+    frame->data[0] = static_cast<char>(kTypeOutput);
+    frame->data[1] = static_cast<char>(stream ? kFlagDeflate : 0);
+    PutLe(frame->data + 2, sessionId, 4);
+    PutLe(frame->data + 6, offset, 8);
+    PutLe(frame->data + 14, size, 4);
+    frame->offset = offset;
+    return frame;
+}
+
+Block *FrameEncoder::Deflate(const char *data, size_t size) {
+    if (broken) {
+        return nullptr;
+    }
+    BufferPool &pool = BufferPool::Instance();
+    Block *frame = pool.Acquire(kHeaderBytes + deflateBound(stream, static_cast<uLong>(size)) + 16);
+
+    stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream->avail_in = static_cast<uInt>(size);
+    size_t used = kHeaderBytes;
+    while (true) {
+        stream->next_out = reinterpret_cast<Bytef *>(frame->data + used);
+        stream->avail_out = static_cast<uInt>(frame->capacity - used);
+        int rc = deflate(stream, Z_SYNC_FLUSH);
+        used = frame->capacity - stream->avail_out;
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            broken = true;
+            pool.Release(frame);
+            return nullptr;
+        }
+        // Sortie non pleine : tout est compressé et vidé
+        if (stream->avail_out > 0) {
+            break;
+        }
+        if (frame->capacity >= BufferPool::kMaxBlockSize) {
+            broken = true;
+            pool.Release(frame);
+            return nullptr;
+        }
+        Block *larger = pool.Acquire(static_cast<size_t>(frame->capacity) * 2);
+        std::memcpy(larger->data, frame->data, used);
+        pool.Release(frame);
+        frame = larger;
+    }
+    frame->size = static_cast<uint32_t>(used);
+    return frame;
+}
+
+} // namespace io
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct z_stream_s;
+
+namespace io {
+
+struct Block;
+
+// Sortie emballée pour un WebSocket binaire : en-tête fixe puis charge,
+// éventuellement compressée en deflate brut avec un seul contexte pour
+// toute la session (chaque trame se termine par un Z_SYNC_FLUSH, comme
+// permessage-deflate). À n'utiliser que depuis un thread à la fois.
+//
+// En-tête, petit-boutiste :
+//   0  u8   type (kTypeOutput)
+//   1  u8   drapeaux (kFlagDeflate)
+//   2  u32  identifiant de session
+//   6  u64  position dans le flux du premier octet (offsets de Scrollback)
+//   14 u32  taille de la charge avant compression
+class FrameEncoder {
+public:
+    static const size_t kHeaderBytes = 18;
+    // Charge brute par trame : une trame tient dans un bloc de 64 Kio
+    static const size_t kMaxPayload = 64 * 1024 - 256;
+    static const uint8_t kTypeOutput = 1;
+    static const uint8_t kFlagDeflate = 1;
+
+    // level de 1 à 9, 0 sans compression
+    FrameEncoder(uint32_t sessionId, int level);
+    ~FrameEncoder();
+
+    // false si le contexte de compression n'a pas pu être créé
+    bool Init();
+
+    // Trame pour au plus kMaxPayload octets ; nullptr si la compression
+    // échoue (le contexte est alors perdu pour la suite)
+    Block *Encode(const char *data, size_t size, uint64_t offset);
+
+private:
+    FrameEncoder(const FrameEncoder &) = delete;
+    FrameEncoder &operator=(const FrameEncoder &) = delete;
+
+    Block *Deflate(const char *data, size_t size);
+
+    uint32_t sessionId;
+    int level;
+    z_stream_s *stream;
+    bool broken;
+};
+
+} // namespace io
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+
+namespace io {
+
+// File MPSC intrusive (Vyukov) : un échange atomique par élément côté
+// producteur, aucun verrou. T porte un std::atomic<T *> next et se
+// construit par défaut (nœud sentinelle).
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(&stub), tail(&stub) {
+        stub.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void Push(T *node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        T *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consommateur unique. nullptr si vide ou si un producteur est en
+    // train de chaîner son élément (il sera vu au tour suivant).
+    T *Pop() {
+        T *first = tail;
+        T *next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (!next) return nullptr;
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+private:
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    std::atomic<T *> head;
+    T *tail;
+    T stub;
+};
+
+} // namespace io
@@ -0,0 +1,291 @@
+#include "io/reactor.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+
+struct Registration {
+    int fd;
+    IoHandler *handler;
+    EventLoop *loop;
+    // Tenu pendant la distribution : Unregister() attend la fin de l'appel en cours
+    std::recursive_mutex mutex;
+    uint32_t events;
+    bool active;
+};
+
+#ifdef __linux__
+
+class EventLoop {
+public:
+    EventLoop() : epollFd(-1), wakeFd(-1), registrations(0) {}
+
+    bool Start() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            return false;
+        }
+        // Réveille epoll_wait() pour libérer les inscriptions retirées
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev) != 0) {
+            if (wakeFd >= 0) {
+                close(wakeFd);
+            }
+            close(epollFd);
+            wakeFd = epollFd = -1;
+            return false;
+        }
+        // Vit aussi longtemps que le processus
+        std::thread([this]() { Run(); }).detach();
+        return true;
+    }
+
+    bool Apply(Registration *registration, uint32_t events) {
+        struct epoll_event ev = {};
+        ev.events = events;
+        ev.data.ptr = registration;
+
+        int op;
+        if (events == 0) {
+            // epoll signale toujours EPOLLHUP : un descripteur en pause doit sortir de l'ensemble
+            op = EPOLL_CTL_DEL;
+        } else {
+            op = registration->events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        }
+
+        if (events == registration->events) {
+            return true;
+        }
+        if (epoll_ctl(epollFd, op, registration->fd, &ev) != 0) {
+            return false;
+        }
+        registration->events = events;
+        return true;
+    }
+
+    void Bury(Registration *registration) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(graveMutex);
+            wake = graveyard.empty();
+            graveyard.push_back(registration);
+        }
+        // Sans évènement, la boucle garderait l'inscription jusqu'au prochain lot
+        if (wake) {
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    std::atomic<size_t> &Count() { return registrations; }
+
+private:
+    void Run() {
+        const int maxEvents = 256;
+        struct epoll_event events[maxEvents];
+
+        for (;;) {
+            // Les inscriptions retirées pendant le lot précédent ne peuvent plus être référencées
+            std::vector<Registration *> dead;
+            {
+                std::lock_guard<std::mutex> lock(graveMutex);
+                dead.swap(graveyard);
+            }
+            for (Registration *registration : dead) {
+                delete registration;
+            }
+
+            int count = epoll_wait(epollFd, events, maxEvents, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR("Reactor: epoll_wait failed: " << errno);
+                return;
+            }
+
+            for (int i = 0; i < count; i++) {
+                Registration *registration = static_cast<Registration *>(events[i].data.ptr);
+                if (!registration) {
+                    // Réveil : le cimetière est vidé au tour suivant
+                    uint64_t value;
+                    ssize_t ignored = read(wakeFd, &value, sizeof(value));
+                    (void)ignored;
+                    continue;
+                }
+                std::lock_guard<std::recursive_mutex> lock(registration->mutex);
+
+                uint32_t ready = events[i].events;
+                if (registration->active && (registration->events & EPOLLIN) &&
+                    (ready & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                    registration->handler->OnReadable();
+                }
+                if (registration->active && (registration->events & EPOLLOUT) &&
+                    (ready & (EPOLLOUT | EPOLLHUP | EPOLLERR))) {
+                    registration->handler->OnWritable();
+                }
+            }
+        }
+    }
+
+    int epollFd;
+    int wakeFd;
+    std::atomic<size_t> registrations;
+    std::mutex graveMutex;
+    std::vector<Registration *> graveyard;
+};
+
+static uint32_t EventMask(IoHandler *handler) {
+    uint32_t events = 0;
+    if (handler->WantsRead()) events |= EPOLLIN;
+    if (handler->WantsWrite()) events |= EPOLLOUT;
+    return events;
+}
+
+bool Reactor::Available() {
+    return true;
+}
+
+#else
+
+class EventLoop {};
+
+bool Reactor::Available() {
+    return false;
+}
+
+#endif
+
+Reactor &Reactor::Instance() {
+    static Reactor *reactor = new Reactor();
+    return *reactor;
+}
+
+Reactor::Reactor() {
+    unsigned cores = std::thread::hardware_concurrency();
+    threadCount = std::min(4u, std::max(1u, cores / 2));
+}
+
+bool Reactor::SetThreadCount(unsigned count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loops.empty() || count == 0) {
+        return false;
+    }
+    threadCount = count;
+    return true;
+}
+
+unsigned Reactor::GetThreadCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return threadCount;
+}
+
+bool Reactor::StartLoops() {
+#ifdef __linux__
+    for (unsigned i = 0; i < threadCount; i++) {
+        std::unique_ptr<EventLoop> loop(new EventLoop());
+        if (!loop->Start()) {
+            return !loops.empty();
+        }
+        loops.push_back(std::move(loop));
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+Registration *Reactor::Register(int fd, IoHandler *handler) {
+#ifdef __linux__
+    EventLoop *loop = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (loops.empty() && !StartLoops()) {
+            return nullptr;
+        }
+
+        // La boucle la moins chargée prend le nouveau descripteur
+        for (auto &candidate : loops) {
+            if (!loop || candidate->Count().load() < loop->Count().load()) {
+                loop = candidate.get();
+            }
+        }
+        loop->Count()++;
+    }
+
+    Registration *registration = new Registration();
+    registration->fd = fd;
+    registration->handler = handler;
+    registration->loop = loop;
+    registration->events = 0;
+    registration->active = true;
+
+    std::lock_guard<std::recursive_mutex> lock(registration->mutex);
+    if (!loop->Apply(registration, EventMask(handler))) {
+        loop->Count()--;
+        delete registration;
+        return nullptr;
+    }
+    return registration;
+#else
+    (void)fd;
+    (void)handler;
+    return nullptr;
+#endif
+}
+
+void Reactor::Refresh(Registration *registration) {
+#ifdef __linux__
+    if (!registration) return;
+
+    std::lock_guard<std::recursive_mutex> lock(registration->mutex);
+    if (registration->active) {
+        registration->loop->Apply(registration, EventMask(registration->handler));
+    }
+#else
+    (void)registration;
+#endif
+}
+
+void Reactor::ReadNow(Registration *registration) {
+#ifdef __linux__
+    if (!registration) return;
+
+    std::lock_guard<std::recursive_mutex> lock(registration->mutex);
+    if (registration->active) {
+        registration->handler->OnReadable();
+    }
+#else
+    (void)registration;
+#endif
+}
+
+void Reactor::Unregister(Registration *registration) {
+#ifdef __linux__
+    if (!registration) return;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(registration->mutex);
+        registration->loop->Apply(registration, 0);
+        registration->active = false;
+    }
+    registration->loop->Count()--;
+    registration->loop->Bury(registration);
+#else
+    (void)registration;
+#endif
+}
+
+} // namespace io
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace io {
+
+// Reçoit les évènements d'un descripteur, toujours sur un thread du réacteur.
+// WantsRead()/WantsWrite() sont réévalués par Refresh(), sous le verrou de
+// l'inscription, pour que le dernier appel voie toujours l'état le plus récent.
+class IoHandler {
+public:
+    virtual ~IoHandler() {}
+    virtual void OnReadable() = 0;
+    virtual void OnWritable() {}
+    virtual bool WantsRead() { return true; }
+    virtual bool WantsWrite() { return false; }
+};
+
+struct Registration;
+class EventLoop;
+
+// Petit pool fixe de boucles epoll partagées par tous les terminaux.
+// Hors Linux, Available() renvoie false et chaque terminal garde son thread.
+class Reactor {
+public:
+    static bool Available();
+    static Reactor &Instance();
+
+    // Modifiable uniquement avant la première inscription
+    bool SetThreadCount(unsigned count);
+    unsigned GetThreadCount();
+
+    Registration *Register(int fd, IoHandler *handler);
+    void Refresh(Registration *registration);
+    // Appelle OnReadable() depuis le thread courant, exclusif avec la boucle :
+    // pour vider un descripteur qui ne deviendra peut-être plus lisible
+    void ReadNow(Registration *registration);
+    // Synchrone : au retour, plus aucun appel du handler n'est en cours ni à venir
+    void Unregister(Registration *registration);
+
+private:
+    Reactor();
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    bool StartLoops();
+
+    std::mutex mutex;
+    unsigned threadCount;
+    std::vector<std::unique_ptr<EventLoop>> loops;
+};
+
+} // namespace io
@@ -0,0 +1,241 @@
+#include "io/recorder.h"
+#include "io/buffer_pool.h"
+#include "Logger/logger.h"
+#include <cstring>
+
+namespace io {
+
+static void PutLE(char *out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+Recorder::Recorder()
+    : file(nullptr),
+      index(nullptr),
+      fileOffset(0),
+      nextIndexTime(0),
+      lastTime(0),
+      queuedBytes(0),
+      droppedBytes(0),
+      gapTime(kNoGap),
+      stopping(false),
+      failed(false) {
+}
+
+Recorder::~Recorder() {
+    Close();
+}
+
+bool Recorder::Open(const std::string &path) {
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    index = fopen((path + ".idx").c_str(), "wb");
+    if (!index) {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    uint64_t unixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    char header[20];
+    memcpy(header, "NPTYREC1", 8);
+    PutLE(header + 8, 1, 2);
+    PutLE(header + 10, 0, 2);
+    PutLE(header + 12, unixMs, 8);
+
+    char indexHeader[16];
+    memcpy(indexHeader, "NPTYIDX1", 8);
+    PutLE(indexHeader + 8, 16, 4);
+    PutLE(indexHeader + 12, 0, 4);
+
+    if (fwrite(header, sizeof(header), 1, file) != 1 || fwrite(indexHeader, sizeof(indexHeader), 1, index) != 1) {
+        fclose(file);
+        fclose(index);
+        file = index = nullptr;
+        return false;
+    }
+    fileOffset = sizeof(header);
+
+    writer = std::thread([this]() { this->WriterLoop(); });
+    return true;
+}
+
+void Recorder::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wake.notify_one();
+    }
+    if (writer.joinable()) {
+        writer.join();
+    }
+    // Trames arrivées pendant la dernière écriture : plus écrites
+    DropQueued();
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    if (index) {
+        fclose(index);
+        index = nullptr;
+    }
+}
+
+uint64_t Recorder::Now() const {
+    // steady_clock passe par le vDSO : pas d'appel système
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+void Recorder::Enqueue(Frame *frame, size_t size) {
+    bool accepted = !stopping.load(std::memory_order_relaxed) && !failed.load(std::memory_order_relaxed);
+    if (accepted && queuedBytes.fetch_add(size) + size > kMaxQueuedBytes) {
+        queuedBytes -= size;
+        // Le disque ne suit pas : on perd des données plutôt que de
+        // ralentir la lecture, et le trou est noté dans le fichier.
+        uint64_t none = kNoGap;
+        gapTime.compare_exchange_strong(none, frame->time);
+        droppedBytes += size;
+        accepted = false;
+    }
+    if (!accepted) {
+        BufferPool::Instance().Release(frame->block);
+        delete frame;
+        return;
+    }
+    // Pas de notify : le thread d'écriture se réveille de lui-même
+    queue.Push(frame);
+}
+
+void Recorder::RecordOutput(Block *block) {
+    BufferPool::Retain(block);
+    Frame *frame = new Frame();
+    frame->type = kOutput;
+    frame->time = Now();
+    frame->block = block;
+    Enqueue(frame, block->size);
+}
+
+void Recorder::RecordInput(const char *data, size_t length) {
+    Frame *frame = new Frame();
+    frame->type = kInput;
+    frame->time = Now();
+    frame->block = nullptr;
+    frame->data.assign(data, length);
+    Enqueue(frame, length);
+}
+
+void Recorder::RecordResize(int cols, int rows) {
+    char payload[4];
+    PutLE(payload, static_cast<uint64_t>(cols), 2);
+    PutLE(payload + 2, static_cast<uint64_t>(rows), 2);
+    Frame *frame = new Frame();
+    frame->type = kResize;
+    frame->time = Now();
+    frame->block = nullptr;
+    frame->data.assign(payload, sizeof(payload));
+    Enqueue(frame, sizeof(payload));
+}
+
+bool Recorder::WriteGap(uint64_t bytes, uint64_t time) {
+    char payload[8];
+    PutLE(payload, bytes, 8);
+    return WriteFrame(kGap, time, payload, sizeof(payload));
+}
+
+bool Recorder::WriteFrame(FrameType type, uint64_t time, const char *data, size_t length) {
+    // Les producteurs datent leurs trames avant de les chaîner : deux
+    // threads peuvent se croiser de quelques µs
+    if (time < lastTime) {
+        time = lastTime;
+    }
+    lastTime = time;
+
+    if (time >= nextIndexTime) {
+        char entry[16];
+        PutLE(entry, time, 8);
+        PutLE(entry + 8, fileOffset, 8);
+        if (fwrite(entry, sizeof(entry), 1, index) != 1) {
+            return false;
+        }
+        nextIndexTime = (time / kIndexInterval + 1) * kIndexInterval;
+    }
+
+    char header[13];
+    header[0] = static_cast<char>(type);
+    PutLE(header + 1, length, 4);
+    PutLE(header + 5, time, 8);
+    if (fwrite(header, sizeof(header), 1, file) != 1 ||
+        (length > 0 && fwrite(data, length, 1, file) != 1)) {
+        return false;
+    }
+    fileOffset += sizeof(header) + length;
+    return true;
+}
+
+void Recorder::DropQueued() {
+    while (Frame *frame = queue.Pop()) {
+        queuedBytes -= frame->block ? frame->block->size : frame->data.size();
+        BufferPool::Instance().Release(frame->block);
+        delete frame;
+    }
+}
+
+void Recorder::WriterLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(50), [this]() { return stopping.load(); });
+        }
+        bool last = stopping.load();
+
+        // Trou à placer avant la première trame plus récente que la perte
+        uint64_t gapBytes = droppedBytes.exchange(0);
+        uint64_t gapAt = kNoGap;
+        if (gapBytes > 0) {
+            gapAt = gapTime.exchange(kNoGap);
+            if (gapAt == kNoGap) {
+                gapAt = lastTime;
+            }
+        }
+
+        bool ok = !failed.load();
+        while (Frame *frame = queue.Pop()) {
+            size_t size = frame->block ? frame->block->size : frame->data.size();
+            if (ok && gapBytes > 0 && frame->time > gapAt) {
+                ok = WriteGap(gapBytes, gapAt);
+                gapBytes = 0;
+            }
+            if (ok) {
+                ok = frame->block
+                    ? WriteFrame(frame->type, frame->time, frame->block->data, frame->block->size)
+                    : WriteFrame(frame->type, frame->time, frame->data.data(), frame->data.size());
+            }
+            queuedBytes -= size;
+            BufferPool::Instance().Release(frame->block);
+            delete frame;
+        }
+        if (ok && gapBytes > 0) {
+            ok = WriteGap(gapBytes, gapAt);
+        }
+
+        if (ok) {
+            ok = fflush(file) == 0 && fflush(index) == 0;
+        }
+        if (!ok && !failed.exchange(true)) {
+            LOG_ERROR("Session recording stopped: write error");
+        }
+        if (last) {
+            break;
+        }
+    }
+}
+
+} // namespace io
@@ -0,0 +1,98 @@
+#pragma once
+#include "io/mpsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace io {
+
+struct Block;
+
+// Enregistrement d'une session sur disque par un thread d'écriture dédié.
+//
+// Fichier principal : en-tête "NPTYREC1", version (u16), réservé (u16),
+// heure de début (u64, ms Unix), puis des trames type (u8), longueur (u32),
+// temps (u64, µs depuis le début) suivies de leurs données. Entiers en
+// little-endian.
+//
+// Index "<chemin>.idx" : en-tête "NPTYIDX1", taille d'entrée (u32),
+// réservé (u32), puis une entrée {temps µs, position dans le fichier}
+// (2 x u64) par seconde d'enregistrement. Les entrées ont une taille fixe
+// et sont triées : un lecteur peut projeter le fichier en mémoire et
+// chercher un instant par dichotomie.
+class Recorder {
+public:
+    enum FrameType : uint8_t {
+        kOutput = 1,
+        kInput = 2,
+        kResize = 3,
+        // Octets perdus parce que le disque ne suivait pas (u64)
+        kGap = 4,
+    };
+
+    Recorder();
+    ~Recorder();
+
+    // false en cas d'échec, errno renseigné
+    bool Open(const std::string &path);
+    void Close();
+
+    // Chemin chaud : ni verrou, ni appel système, ni copie ; le bloc est
+    // seulement retenu jusqu'à son écriture.
+    void RecordOutput(Block *block);
+    void RecordInput(const char *data, size_t length);
+    void RecordResize(int cols, int rows);
+
+private:
+    struct Frame {
+        std::atomic<Frame *> next;
+        FrameType type;
+        uint64_t time;
+        Block *block;
+        std::string data;
+    };
+
+    static const size_t kMaxQueuedBytes = 64 * 1024 * 1024;
+    static const uint64_t kIndexInterval = 1000000;
+    static const uint64_t kNoGap = UINT64_MAX;
+
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+
+    uint64_t Now() const;
+    void Enqueue(Frame *frame, size_t size);
+    void WriterLoop();
+    // Trame kGap, datée de la première perte
+    bool WriteGap(uint64_t bytes, uint64_t time);
+    bool WriteFrame(FrameType type, uint64_t time, const char *data, size_t length);
+    // Libère les trames encore en file sans les écrire
+    void DropQueued();
+
+    FILE *file;
+    FILE *index;
+    uint64_t fileOffset;
+    uint64_t nextIndexTime;
+    // Dernier temps écrit : les trames restent dans l'ordre chronologique
+    uint64_t lastTime;
+    std::chrono::steady_clock::time_point start;
+
+    MpscQueue<Frame> queue;
+    std::atomic<size_t> queuedBytes;
+    std::atomic<uint64_t> droppedBytes;
+    // Temps de la première trame perdue depuis la dernière kGap
+    std::atomic<uint64_t> gapTime;
+    std::atomic<bool> stopping;
+    std::atomic<bool> failed;
+
+    // Seulement pour le sommeil du thread d'écriture et son arrêt
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+};
+
+} // namespace io
@@ -0,0 +1,99 @@
+#include "io/scrollback.h"
+#include <algorithm>
+#include <cstring>
+
+namespace io {
+
+Scrollback::Scrollback(size_t capacity) : capacity(capacity), retained(0), end(0) {
+}
+
+void Scrollback::Append(const char *data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (length == 0) return;
+
+    if (capacity == 0) {
+        end += length;
+        return;
+    }
+    if (!ring) {
+        ring.reset(new char[capacity]);
+    }
+
+    // Seule la fin d'un très gros bloc tient dans l'anneau
+    if (length > capacity) {
+        end += length - capacity;
+        data += length - capacity;
+        length = capacity;
+    }
+
+    size_t position = static_cast<size_t>(end % capacity);
+    size_t first = std::min(length, capacity - position);
+    memcpy(ring.get() + position, data, first);
+    memcpy(ring.get(), data + first, length - first);
+
+    end += length;
+    retained = std::min(capacity, retained + length);
+}
+
+void Scrollback::CopyOut(uint64_t offset, char *dest, size_t length) const {
+    size_t position = static_cast<size_t>(offset % capacity);
+    size_t first = std::min(length, capacity - position);
+    memcpy(dest, ring.get() + position, first);
+    memcpy(dest + first, ring.get(), length - first);
+}
+
+size_t Scrollback::Read(uint64_t fromOffset, char *dest, size_t maxBytes, uint64_t *start) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t from = std::min(std::max(fromOffset, BeginLocked()), end);
+    size_t length = static_cast<size_t>(std::min<uint64_t>(end - from, maxBytes));
+
+    if (length > 0) {
+        CopyOut(from, dest, length);
+    }
+    *start = from;
+    return length;
+}
+
+size_t Scrollback::Available(uint64_t fromOffset) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t from = std::min(std::max(fromOffset, BeginLocked()), end);
+    return static_cast<size_t>(end - from);
+}
+
+uint64_t Scrollback::Begin() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return BeginLocked();
+}
+
+uint64_t Scrollback::End() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return end;
+}
+
+void Scrollback::SetCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytes == capacity) return;
+
+    std::unique_ptr<char[]> resized;
+    size_t kept = std::min(retained, bytes);
+    if (bytes > 0 && kept > 0) {
+        // Les octets gardent leur position modulo la nouvelle capacité
+        resized.reset(new char[bytes]);
+        uint64_t from = end - kept;
+        size_t position = static_cast<size_t>(from % bytes);
+        size_t first = std::min(kept, bytes - position);
+        CopyOut(from, resized.get() + position, first);
+        CopyOut(from + first, resized.get(), kept - first);
+    }
+
+    ring = std::move(resized);
+    capacity = bytes;
+    retained = kept;
+}
+
+size_t Scrollback::Capacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+} // namespace io
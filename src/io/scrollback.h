@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace io {
+
+// Historique brut de la sortie d'un terminal, dans un anneau de taille
+// fixe. Chaque octet est repéré par sa position dans le flux (offset
+// croissant depuis le démarrage), ce qui permet à un client de reprendre
+// là où il s'était arrêté.
+class Scrollback {
+public:
+    explicit Scrollback(size_t capacity);
+
+    void Append(const char *data, size_t length);
+
+    // Copie au plus maxBytes à partir de fromOffset dans dest. Si cette
+    // position a déjà été écrasée, la copie démarre au plus ancien octet
+    // conservé ; *start reçoit la position effective.
+    size_t Read(uint64_t fromOffset, char *dest, size_t maxBytes, uint64_t *start);
+
+    // Octets disponibles à partir de fromOffset (après le même ajustement)
+    size_t Available(uint64_t fromOffset);
+
+    // Plus ancien octet conservé et fin du flux
+    uint64_t Begin();
+    uint64_t End();
+
+    // Change la capacité en gardant les octets les plus récents (0 désactive)
+    void SetCapacity(size_t bytes);
+    size_t Capacity();
+
+private:
+    Scrollback(const Scrollback &) = delete;
+    Scrollback &operator=(const Scrollback &) = delete;
+
+    uint64_t BeginLocked() const { return end - retained; }
+    void CopyOut(uint64_t offset, char *dest, size_t length) const;
+
+    std::mutex mutex;
+    // Alloué au premier Append() : un terminal muet ne coûte rien
+    std::unique_ptr<char[]> ring;
+    size_t capacity;
+    size_t retained;
+    uint64_t end;
+};
+
+} // namespace io
@@ -0,0 +1,52 @@
+#include "io/shared_ring.h"
+#include <cstring>
+
+namespace io {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Atomics words must be plain 32-bit integers");
+
+SharedRing::SharedRing(char *memory, size_t length)
+    : header(memory),
+      data(memory + kHeaderBytes),
+      capacity(static_cast<uint32_t>(length - kHeaderBytes)) {
+    // Un anneau réutilisé repart de zéro
+    std::memset(header, 0, kHeaderBytes);
+}
+
+bool SharedRing::IsValidLength(size_t length) {
+    if (length < kHeaderBytes + kMinCapacity) {
+        return false;
+    }
+    size_t size = length - kHeaderBytes;
+    return size <= (size_t(1) << 31) && (size & (size - 1)) == 0;
+}
+
+bool SharedRing::Write(const char *bytes, size_t size) {
+    uint32_t head = Slot(Head).load(std::memory_order_relaxed);
+    uint32_t tail = Slot(Tail).load(std::memory_order_acquire);
+    uint32_t used = head - tail;
+    // used > capacity : tail corrompu côté JS, on ne touche à rien
+    if (used > capacity || size > capacity - used) {
+        Slot(Overflows).fetch_add(1);
+        Slot(DroppedBytes).fetch_add(static_cast<uint32_t>(size));
+        return false;
+    }
+
+    uint32_t at = head & (capacity - 1);
+    size_t first = size < capacity - at ? size : capacity - at;
+    std::memcpy(data + at, bytes, first);
+    std::memcpy(data, bytes + first, size - first);
+    // seq_cst : lu avant Waiting, pendant du store de JS (pas de réveil perdu)
+    Slot(Head).store(head + static_cast<uint32_t>(size));
+    return true;
+}
+
+void SharedRing::Close() {
+    Slot(Closed).store(1);
+}
+
+bool SharedRing::TakeWaiter() {
+    return Slot(Waiting).load() != 0 && Slot(Waiting).exchange(0) != 0;
+}
+
+} // namespace io
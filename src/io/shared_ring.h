@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace io {
+
+// Anneau à un producteur (la lecture du PTY) et un consommateur (JS, par
+// Atomics) posé sur la mémoire d'un SharedArrayBuffer. L'en-tête est fait
+// de mots de 32 bits ; les positions sont des totaux qui bouclent à 2^32,
+// la capacité est donc une puissance de deux.
+class SharedRing {
+public:
+    static const size_t kHeaderBytes = 64;
+    static const size_t kMinCapacity = 4096;
+
+    // Index des mots de l'en-tête (Int32Array côté JS)
+    enum Word {
+        Head = 0,         // octets écrits, avancé par le natif
+        Tail = 1,         // octets consommés, avancé par JS
+        Waiting = 2,      // posé par JS avant Atomics.wait(), remis à 0 au réveil
+        Overflows = 3,    // morceaux perdus faute de place
+        DroppedBytes = 4, // octets perdus (boucle à 2^32)
+        Closed = 5        // 1 une fois la sortie terminée
+    };
+
+    // memory doit être aligné sur 4 octets
+    SharedRing(char *memory, size_t length);
+
+    static bool IsValidLength(size_t length);
+
+    // Tout ou rien : un morceau qui ne tient pas est compté perdu
+    bool Write(const char *data, size_t size);
+    void Close();
+
+    // true si le consommateur attend : à l'appelant de le réveiller
+    bool TakeWaiter();
+
+private:
+    std::atomic<uint32_t> &Slot(Word word) {
+        // Mots partagés avec Atomics : même représentation qu'un uint32_t
+        return *reinterpret_cast<std::atomic<uint32_t> *>(header + word * sizeof(uint32_t));
+    }
+
+    char *header;
+    char *data;
+    uint32_t capacity;
+};
+
+} // namespace io
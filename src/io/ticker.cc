@@ -0,0 +1,84 @@
+#include "io/ticker.h"
+#include <algorithm>
+
+namespace io {
+
+Ticker &Ticker::Instance() {
+    // Jamais détruit, comme le pool de tampons et le réacteur
+    static Ticker *ticker = new Ticker();
+    return *ticker;
+}
+
+Ticker::Ticker() : ticking(nullptr), running(false) {
+}
+
+void Ticker::Add(TickHandler *handler, std::chrono::milliseconds interval) {
+    Insert(Entry{handler, interval, std::chrono::steady_clock::now() + interval, false});
+}
+
+void Ticker::Schedule(TickHandler *handler, std::chrono::milliseconds delay) {
+    Insert(Entry{handler, delay, std::chrono::steady_clock::now() + delay, true});
+}
+
+void Ticker::Insert(const Entry &entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(entry);
+
+    if (!running) {
+        running = true;
+        std::thread([this]() { this->Run(); }).detach();
+    } else {
+        wake.notify_one();
+    }
+}
+
+void Ticker::Remove(TickHandler *handler) {
+    std::unique_lock<std::mutex> lock(mutex);
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [handler](const Entry &entry) { return entry.handler == handler; }),
+                  entries.end());
+    idle.wait(lock, [this, handler]() { return ticking != handler; });
+    wake.notify_one();
+}
+
+void Ticker::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!entries.empty()) {
+        auto now = std::chrono::steady_clock::now();
+        auto next = now + std::chrono::hours(1);
+        TickHandler *due = nullptr;
+
+        for (auto entry = entries.begin(); entry != entries.end(); ++entry) {
+            if (entry->next <= now) {
+                due = entry->handler;
+                if (entry->once) {
+                    entries.erase(entry);
+                    break;
+                }
+                // En retard (thread occupé) : on ne rattrape pas les ticks perdus
+                entry->next += entry->interval;
+                if (entry->next <= now) {
+                    entry->next = now + entry->interval;
+                }
+                break;
+            }
+            next = std::min(next, entry->next);
+        }
+
+        if (!due) {
+            wake.wait_until(lock, next);
+            continue;
+        }
+
+        // Appelé hors verrou ; entries peut changer entre-temps
+        ticking = due;
+        lock.unlock();
+        due->OnTick();
+        lock.lock();
+        ticking = nullptr;
+        idle.notify_all();
+    }
+    running = false;
+}
+
+} // namespace io
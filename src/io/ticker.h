@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace io {
+
+class TickHandler {
+public:
+    virtual ~TickHandler() {}
+    virtual void OnTick() = 0;
+};
+
+// Horloge partagée par tous les terminaux : un seul thread appelle
+// OnTick() de chaque abonné à sa propre période. Le thread n'existe que
+// tant qu'il y a des abonnés.
+class Ticker {
+public:
+    static Ticker &Instance();
+
+    void Add(TickHandler *handler, std::chrono::milliseconds interval);
+    // Un seul OnTick() dans delay, sans répétition
+    void Schedule(TickHandler *handler, std::chrono::milliseconds delay);
+    // Synchrone : au retour, OnTick() n'est plus en cours ni appelé pour handler
+    void Remove(TickHandler *handler);
+
+private:
+    struct Entry {
+        TickHandler *handler;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next;
+        bool once;
+    };
+
+    Ticker();
+    Ticker(const Ticker &) = delete;
+    Ticker &operator=(const Ticker &) = delete;
+
+    void Insert(const Entry &entry);
+    void Run();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<Entry> entries;
+    TickHandler *ticking;
+    bool running;
+};
+
+} // namespace io
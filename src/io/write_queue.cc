@@ -0,0 +1,178 @@
+#include "io/write_queue.h"
+#include "vt/framing.h"
+
+namespace io {
+
+// Au plus limit octets de data, coupés hors d'un caractère UTF-8 ou d'une
+// séquence d'échappement quand c'est possible
+static size_t CutAt(const char *data, size_t length, size_t limit) {
+    if (length <= limit) {
+        return length;
+    }
+    size_t tail = vt::IncompleteTail(data, limit);
+    return tail < limit ? limit - tail : limit;
+}
+
+WriteQueue::WriteQueue() : frontOffset(0), frontRemaining(0), inFlight(0), pushed(0), written(0) {
+}
+
+void WriteQueue::Push(const char *data, size_t length) {
+    if (length == 0) return;
+
+    // Un segment pris par TakeFront() a déjà quitté la file : on peut
+    // toujours compléter le dernier, sauf s'il s'agit d'un collage
+    if (!segments.empty() && !segments.back().paste && segments.back().data.size() + length <= kSegmentSize) {
+        segments.back().data.append(data, length);
+        pushed += length;
+        return;
+    }
+    // Une grosse écriture part en segments de kSegmentSize au plus : le
+    // thread d'écriture peut s'arrêter entre deux et l'urgent s'intercaler
+    pushed += length;
+    while (length > 0) {
+        size_t count = CutAt(data, length, kSegmentSize);
+        segments.push_back(Segment{std::string(data, count), false, false});
+        data += count;
+        length -= count;
+    }
+}
+
+void WriteQueue::PushPaste(const char *data, size_t length) {
+    if (length == 0) return;
+
+    segments.push_back(Segment{std::string(data, length), true, false});
+    pushed += length;
+}
+
+uint64_t WriteQueue::PushUrgent(const char *data, size_t length) {
+    uint64_t position = written + inFlight + frontRemaining + urgent.size();
+    urgent.append(data, length);
+    pushed += length;
+    return position;
+}
+
+size_t WriteQueue::DropPastes() {
+    size_t dropped = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        Segment &segment = segments[i];
+        if (segment.paste && !segment.dropped) {
+            if (i == 0 && frontRemaining > 0) {
+                // La tranche entamée finit d'abord ; seule la suite est
+                // abandonnée, dans un segment à part
+                size_t keep = frontOffset + frontRemaining;
+                if (keep < segment.data.size()) {
+                    Segment rest{segment.data.substr(keep), true, true};
+                    segment.data.resize(keep);
+                    dropped += rest.data.size();
+                    segments.insert(segments.begin() + 1, std::move(rest));
+                    i++;
+                }
+                continue;
+            }
+            segment.dropped = true;
+            dropped += segment.data.size() - (i == 0 ? frontOffset : 0);
+        }
+    }
+    return dropped;
+}
+
+void WriteQueue::SkipDropped() {
+    // Les octets abandonnés gardent leur place dans le flux : les rappels
+    // d'écriture positionnés après eux restent justes
+    while (urgent.empty() && !segments.empty() && segments.front().dropped) {
+        written += segments.front().data.size() - frontOffset;
+        segments.pop_front();
+        frontOffset = 0;
+    }
+}
+
+const char *WriteQueue::Front(size_t *length) {
+    if (frontRemaining > 0) {
+        *length = frontRemaining;
+        return segments.front().data.data() + frontOffset;
+    }
+    if (!urgent.empty()) {
+        *length = urgent.size();
+        return urgent.data();
+    }
+    SkipDropped();
+    if (segments.empty()) {
+        *length = 0;
+        return nullptr;
+    }
+    *length = UnitLength();
+    return segments.front().data.data() + frontOffset;
+}
+
+size_t WriteQueue::UnitLength() const {
+    const Segment &front = segments.front();
+    size_t length = front.data.size() - frontOffset;
+    return front.paste ? CutAt(front.data.data() + frontOffset, length, kPasteChunk) : length;
+}
+
+void WriteQueue::Consume(size_t length) {
+    if (length == 0) return;
+
+    written += length;
+    if (frontRemaining == 0 && !urgent.empty()) {
+        // Front() n'a servi que la voie urgente
+        urgent.erase(0, length);
+        return;
+    }
+    // Front() n'a servi qu'une unité du segment de tête
+    size_t unit = frontRemaining > 0 ? frontRemaining : UnitLength();
+    frontRemaining = unit - length;
+    frontOffset += length;
+    if (frontOffset == segments.front().data.size()) {
+        segments.pop_front();
+        frontOffset = 0;
+    }
+}
+
+bool WriteQueue::TakeFront(std::string *segment) {
+    if (!urgent.empty()) {
+        segment->swap(urgent);
+        urgent.clear();
+        inFlight = segment->size();
+        return true;
+    }
+    SkipDropped();
+    if (segments.empty()) {
+        return false;
+    }
+
+    Segment &front = segments.front();
+    size_t unit = UnitLength();
+    if (unit < front.data.size() - frontOffset) {
+        // Une tranche seulement : le reste du collage attend son tour
+        segment->assign(front.data, frontOffset, unit);
+        frontOffset += unit;
+        inFlight = segment->size();
+        return true;
+    }
+
+    segment->swap(front.data);
+    if (frontOffset > 0) {
+        segment->erase(0, frontOffset);
+        frontOffset = 0;
+    }
+    segments.pop_front();
+    inFlight = segment->size();
+    return true;
+}
+
+void WriteQueue::Acknowledge(size_t length) {
+    written += length;
+    inFlight = 0;
+}
+
+void WriteQueue::Clear() {
+    urgent.clear();
+    segments.clear();
+    frontOffset = 0;
+    frontRemaining = 0;
+    inFlight = 0;
+    written = pushed;
+}
+
+} // namespace io
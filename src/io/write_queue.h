@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace io {
+
+// File d'entrée d'un terminal. Les petites écritures JS sont accolées dans
+// un même segment pour partir vers le PTY en un seul appel système ; les
+// grosses sont découpées en segments de kSegmentSize au plus.
+// Trois sortes d'entrée : urgente (Ctrl-C...) qui passe devant tout,
+// ordinaire, et collage, écrit par tranches et abandonnable.
+// Non synchronisée : protégée par le mutex d'écriture du terminal.
+class WriteQueue {
+public:
+    WriteQueue();
+
+    void Push(const char *data, size_t length);
+    // Collage : segment à part, servi par tranches de kPasteChunk pour que
+    // les octets urgents puissent s'intercaler
+    void PushPaste(const char *data, size_t length);
+    // Octets urgents, écrits avant tout ce qui attend mais jamais au milieu
+    // d'un segment ou d'une tranche de collage déjà entamé. Renvoie leur
+    // position dans le flux écrit : tout octet en file au-delà est décalé
+    // d'autant.
+    uint64_t PushUrgent(const char *data, size_t length);
+    // Les collages pas encore écrits sont sautés sans être envoyés (ils
+    // comptent alors comme écrits). Renvoie le nombre d'octets abandonnés.
+    size_t DropPastes();
+
+    bool Empty() const { return urgent.empty() && segments.empty(); }
+    // Octets poussés mais pas encore écrits (segment en cours d'écriture compris)
+    size_t Size() const { return static_cast<size_t>(pushed - written); }
+    uint64_t TotalPushed() const { return pushed; }
+    uint64_t TotalWritten() const { return written; }
+
+    // Écriture sur place (réacteur) : segment de tête puis Consume()
+    const char *Front(size_t *length);
+    void Consume(size_t length);
+
+    // Écriture hors verrou (thread d'écriture) : le segment sort de la file,
+    // Acknowledge() comptabilise ensuite ce qui a réellement été écrit.
+    bool TakeFront(std::string *segment);
+    void Acknowledge(size_t length);
+
+    // Abandonne tout ce qui reste (PTY fermé)
+    void Clear();
+
+private:
+    static const size_t kSegmentSize = 64 * 1024;
+    static const size_t kPasteChunk = 16 * 1024;
+
+    struct Segment {
+        std::string data;
+        bool paste;
+        bool dropped;
+    };
+
+    void SkipDropped();
+    // Octets du segment de tête servis d'un bloc : tout le segment, ou une
+    // tranche de collage coupée hors d'un caractère ou d'une séquence
+    size_t UnitLength() const;
+
+    std::string urgent;
+    std::deque<Segment> segments;
+    size_t frontOffset;
+    // Reste d'un segment ou d'une tranche de collage en partie écrit par
+    // Consume() : il passe avant l'urgent
+    size_t frontRemaining;
+    // Pris par TakeFront() et pas encore acquitté
+    size_t inFlight;
+    uint64_t pushed;
+    uint64_t written;
+};
+
+} // namespace io
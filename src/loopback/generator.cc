@@ -0,0 +1,181 @@
+#include "loopback/generator.h"
+#include <cstring>
+
+namespace loopback {
+
+static const char *const kWords[] = {
+    "total", "drwxr-xr-x", "user", "staff", "4096", "Makefile", "src", "build", "README.md", "index.js",
+    "warning:", "error:", "done", "compiling", "linking", "0.42s", "ok", "test", "passed", "node_modules",
+};
+static const size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+// Caractères larges ou combinés, pour la validation UTF-8 et le modèle d'écran
+static const char *const kWide[] = {"é", "ß", "中", "文", "─", "│", "✓", "😀", "e\xcc\x81"};
+static const size_t kWideCount = sizeof(kWide) / sizeof(kWide[0]);
+
+Generator::Generator(Kind kind, uint32_t seed) : kind(kind), state(seed ? seed : 0x9E3779B9u), position(0) {
+}
+
+uint32_t Generator::Next() {
+    // xorshift32 : rapide et identique sur toutes les plateformes
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void Generator::Fill(char *out, size_t length) {
+    while (length > 0) {
+        if (position == chunk.size()) {
+            Refill();
+        }
+        size_t count = chunk.size() - position;
+        if (count > length) {
+            count = length;
+        }
+        std::memcpy(out, chunk.data() + position, count);
+        position += count;
+        out += count;
+        length -= count;
+    }
+}
+
+void Generator::Refill() {
+    chunk.clear();
+    position = 0;
+    // Fragments de quelques Kio : peu d'appels, sans trop de mémoire
+    while (chunk.size() < 4096) {
+        switch (kind) {
+        case Kind::Text:
+            AppendWords(4 + Below(12));
+            chunk.append("\r\n");
+            break;
+        case Kind::Ansi:
+            AppendAnsi();
+            break;
+        case Kind::Fuzz:
+            AppendFuzz();
+            break;
+        }
+    }
+}
+
+void Generator::AppendWords(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            chunk.push_back(' ');
+        }
+        chunk.append(kWords[Below(kWordCount)]);
+    }
+}
+
+void Generator::AppendAnsi() {
+    switch (Below(6)) {
+    case 0:
+        // Couleur 16, 256 ou RVB
+        chunk.append("\x1b[").append(std::to_string(30 + Below(8))).append("m");
+        break;
+    case 1:
+        chunk.append("\x1b[38;5;").append(std::to_string(Below(256))).append("m");
+        break;
+    case 2:
+        chunk.append("\x1b[48;2;").append(std::to_string(Below(256))).append(";")
+            .append(std::to_string(Below(256))).append(";").append(std::to_string(Below(256))).append("m");
+        break;
+    case 3:
+        // Déplacement puis effacement, comme un programme plein écran
+        chunk.append("\x1b[").append(std::to_string(1 + Below(30))).append(";")
+            .append(std::to_string(1 + Below(120))).append("H\x1b[K");
+        break;
+    case 4:
+        for (uint32_t i = 0, n = 1 + Below(8); i < n; i++) {
+            chunk.append(kWide[Below(kWideCount)]);
+        }
+        break;
+    default:
+        break;
+    }
+    AppendWords(1 + Below(6));
+    chunk.append("\x1b[0m");
+    if (Below(4) == 0) {
+        chunk.append("\r\n");
+    }
+}
+
+void Generator::AppendFuzz() {
+    switch (Below(10)) {
+    case 0: {
+        // CSI aux paramètres démesurés, parfois sans octet final
+        chunk.append("\x1b[");
+        if (Below(3) == 0) {
+            chunk.push_back(static_cast<char>("?>=<"[Below(4)]));
+        }
+        for (uint32_t i = 0, n = Below(64); i < n; i++) {
+            chunk.append(std::to_string(Next() % (Below(2) ? 10u : 4000000000u)));
+            chunk.push_back(Below(4) == 0 ? ':' : ';');
+        }
+        if (Below(4) != 0) {
+            chunk.push_back(static_cast<char>(0x40 + Below(0x3F)));
+        }
+        break;
+    }
+    case 1: {
+        // OSC long, terminé par BEL, ST, ou pas du tout
+        chunk.append("\x1b]").append(std::to_string(Below(1000))).append(";");
+        for (uint32_t i = 0, n = Below(600); i < n; i++) {
+            chunk.push_back(static_cast<char>(0x20 + Below(0x5F)));
+        }
+        uint32_t end = Below(3);
+        chunk.append(end == 0 ? "\x07" : end == 1 ? "\x1b\\" : "");
+        break;
+    }
+    case 2:
+        // DCS / APC / PM / SOS avec contenu arbitraire
+        chunk.append("\x1b").push_back(static_cast<char>("P_^X"[Below(4)]));
+        for (uint32_t i = 0, n = Below(300); i < n; i++) {
+            chunk.push_back(static_cast<char>(Next()));
+        }
+        if (Below(2) == 0) {
+            chunk.append("\x1b\\");
+        }
+        break;
+    case 3: {
+        // UTF-8 invalide : continuation isolée, forme trop longue,
+        // surrogat, séquence tronquée, octets interdits
+        static const char *const kInvalid[] = {"\x80", "\xbf\xbf", "\xc0\x80", "\xe0\x80\xaf", "\xed\xa0\x80",
+                                               "\xf0\x9f\x98", "\xf4\x90\x80\x80", "\xfe", "\xff", "\xc3"};
+        chunk.append(kInvalid[Below(sizeof(kInvalid) / sizeof(kInvalid[0]))]);
+        break;
+    }
+    case 4:
+        // Contrôles C0 et C1 (forme 8 bits)
+        for (uint32_t i = 0, n = 1 + Below(16); i < n; i++) {
+            chunk.push_back(static_cast<char>(Below(2) ? Below(0x20) : 0x80 + Below(0x20)));
+        }
+        break;
+    case 5:
+        // ESC en cascade et ESC suivi de n'importe quoi
+        for (uint32_t i = 0, n = 1 + Below(8); i < n; i++) {
+            chunk.push_back('\x1b');
+            if (Below(2)) {
+                chunk.push_back(static_cast<char>(Next()));
+            }
+        }
+        break;
+    case 6:
+        for (uint32_t i = 0, n = Below(256); i < n; i++) {
+            chunk.push_back(static_cast<char>(Next()));
+        }
+        break;
+    case 7:
+        // Modes et redimensionnements extrêmes
+        chunk.append("\x1b[?").append(std::to_string(Below(3000))).append(Below(2) ? "h" : "l");
+        chunk.append("\x1b[").append(std::to_string(Next())).append(";").append(std::to_string(Next())).append("r");
+        break;
+    default:
+        AppendAnsi();
+        break;
+    }
+}
+
+} // namespace loopback
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace loopback {
+
+// Sortie synthétique reproductible : même graine, mêmes octets
+class Generator {
+public:
+    enum class Kind {
+        Text, // lignes de mots ASCII
+        Ansi, // couleurs SGR, déplacements du curseur, UTF-8 multi-octets
+        Fuzz  // séquences tronquées ou démesurées, UTF-8 invalide, contrôles C0/C1
+    };
+
+    Generator(Kind kind, uint32_t seed);
+
+    // Remplit exactement length octets
+    void Fill(char *out, size_t length);
+
+private:
+    uint32_t Next();
+    uint32_t Below(uint32_t bound) { return Next() % bound; }
+    void Refill();
+    void AppendWords(size_t count);
+    void AppendAnsi();
+    void AppendFuzz();
+
+    Kind kind;
+    uint32_t state;
+    // Fragment en cours, consommé à partir de position
+    std::string chunk;
+    size_t position;
+};
+
+} // namespace loopback
@@ -0,0 +1,353 @@
+#include "loopback/loopback_pty.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#endif
+
+namespace loopback {
+
+// Identifiants hors de la plage des vrais PID (pid_max Linux <= 2^22)
+static std::atomic<uint32_t> nextPid(0x7F000000u);
+
+// Erreurs au format de backend::LastError()
+static void SetError(bool noData) {
+#ifdef _WIN32
+    SetLastError(noData ? ERROR_NO_DATA : ERROR_BROKEN_PIPE);
+#else
+    errno = noData ? EAGAIN : EPIPE;
+#endif
+}
+
+LoopbackPty::LoopbackPty(const backend::LoopbackOptions &options)
+    : options(options),
+      replayPosition(0),
+      replayPasses(0),
+      produced(0),
+      tokens(0),
+      inputPosition(0),
+      started(false),
+      closed(false),
+      cancelled(false),
+      exited(false),
+      cols(0),
+      rows(0),
+      pid(0),
+      exitListener(nullptr),
+      exitNotified(false) {
+}
+
+LoopbackPty::~LoopbackPty() {
+    UnwatchExit();
+    Close();
+}
+
+bool LoopbackPty::Create(int16_t cols, int16_t rows) {
+    this->cols = cols;
+    this->rows = rows;
+    return true;
+}
+
+bool LoopbackPty::Start(const backend::SpawnOptions &) {
+    switch (options.source) {
+    case backend::LoopbackOptions::Source::Replay:
+        if (!options.data.empty()) {
+            replay = options.data;
+        } else if (!LoadReplay()) {
+            return false;
+        }
+        break;
+    case backend::LoopbackOptions::Source::Text:
+        generator = std::make_unique<Generator>(Generator::Kind::Text, options.seed);
+        break;
+    case backend::LoopbackOptions::Source::Ansi:
+        generator = std::make_unique<Generator>(Generator::Kind::Ansi, options.seed);
+        break;
+    case backend::LoopbackOptions::Source::Fuzz:
+        generator = std::make_unique<Generator>(Generator::Kind::Fuzz, options.seed);
+        break;
+    case backend::LoopbackOptions::Source::Echo:
+        break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pid = nextPid.fetch_add(1, std::memory_order_relaxed);
+    refilledAt = Clock::now();
+    started = true;
+    LOG_DEBUG("Loopback PTY started, PID: " << pid << ", " << replay.size() << " bytes to replay");
+    return true;
+}
+
+bool LoopbackPty::LoadReplay() {
+    FILE *file = fopen(options.file.c_str(), "rb");
+    if (!file) {
+        LOG_ERROR("Failed to open replay file: " << options.file);
+        return false;
+    }
+    std::string content;
+    char buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, count);
+    }
+    fclose(file);
+
+    // Enregistrement io::Recorder : seules les trames de sortie sont rejouées
+    static const char kMagic[] = "NPTYREC1";
+    const size_t kHeaderSize = 8 + 2 + 2 + 8;
+    const size_t kFrameHeaderSize = 1 + 4 + 8;
+    if (content.size() < kHeaderSize || content.compare(0, 8, kMagic) != 0) {
+        replay = std::move(content);
+        return true;
+    }
+    size_t position = kHeaderSize;
+    while (position + kFrameHeaderSize <= content.size()) {
+        const unsigned char *header = reinterpret_cast<const unsigned char *>(content.data() + position);
+        uint32_t length = header[1] | (header[2] << 8) | (header[3] << 16) | (static_cast<uint32_t>(header[4]) << 24);
+        position += kFrameHeaderSize;
+        if (length > content.size() - position) {
+            // Enregistrement tronqué (processus tué pendant l'écriture)
+            break;
+        }
+        if (header[0] == 1) {
+            replay.append(content, position, length);
+        }
+        position += length;
+    }
+    return true;
+}
+
+bool LoopbackPty::Write(const char *data, uint32_t length, uint32_t *written) {
+    *written = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed || exited.load()) {
+        SetError(false);
+        return false;
+    }
+    if (options.echo) {
+        input.append(data, length);
+        wake.notify_all();
+    }
+    *written = length;
+    return true;
+}
+
+bool LoopbackPty::TryWrite(const char *data, uint32_t length, uint32_t *written) {
+    *written = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed || exited.load()) {
+        SetError(false);
+        return false;
+    }
+    if (!options.echo) {
+        *written = length;
+        return true;
+    }
+    size_t pending = input.size() - inputPosition;
+    if (pending >= kMaxPendingInput) {
+        SetError(true);
+        return false;
+    }
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(length, kMaxPendingInput - pending));
+    input.append(data, count);
+    wake.notify_all();
+    *written = count;
+    return true;
+}
+
+bool LoopbackPty::Read(char *data, uint32_t length, uint32_t *read) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return ReadLocked(lock, data, length, read, true);
+}
+
+bool LoopbackPty::TryRead(char *data, uint32_t length, uint32_t *read) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return ReadLocked(lock, data, length, read, false);
+}
+
+bool LoopbackPty::ReadLocked(std::unique_lock<std::mutex> &lock, char *data, uint32_t length, uint32_t *read, bool wait) {
+    *read = 0;
+    while (true) {
+        if (closed) {
+            SetError(false);
+            return false;
+        }
+        if (cancelled) {
+            SetError(true);
+            return false;
+        }
+
+        // L'écho passe avant la source et n'est pas limité en débit
+        if (inputPosition < input.size()) {
+            size_t count = std::min<size_t>(length, input.size() - inputPosition);
+            std::memcpy(data, input.data() + inputPosition, count);
+            inputPosition += count;
+            if (inputPosition == input.size()) {
+                input.clear();
+                inputPosition = 0;
+            } else if (inputPosition > 65536 && inputPosition > input.size() / 2) {
+                input.erase(0, inputPosition);
+                inputPosition = 0;
+            }
+            *read = static_cast<uint32_t>(count);
+            return true;
+        }
+
+        if (SourceDone()) {
+            bool first = !exited.exchange(true);
+            lock.unlock();
+            if (first) {
+                Finish();
+            }
+            SetError(false);
+            return false;
+        }
+
+        Clock::time_point now = Clock::now();
+        uint64_t allowed = Allowance(now);
+        if (allowed > 0) {
+            size_t count = Produce(data, static_cast<size_t>(std::min<uint64_t>(length, allowed)));
+            if (options.bytesPerSecond) {
+                tokens -= static_cast<double>(count);
+            }
+            *read = static_cast<uint32_t>(count);
+            return true;
+        }
+
+        if (!wait) {
+            SetError(true);
+            return false;
+        }
+        if (options.source == backend::LoopbackOptions::Source::Echo) {
+            wake.wait(lock);
+        } else {
+            // Jusqu'au prochain octet autorisé, ou plus tôt pour un écho
+            double seconds = (1.0 - tokens) / static_cast<double>(options.bytesPerSecond);
+            wake.wait_until(lock, now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)));
+        }
+    }
+}
+
+uint64_t LoopbackPty::Allowance(Clock::time_point now) {
+    if (options.source == backend::LoopbackOptions::Source::Echo) {
+        return 0;
+    }
+    uint64_t remaining = std::numeric_limits<uint64_t>::max();
+    if (generator && options.totalBytes) {
+        remaining = options.totalBytes - produced;
+    }
+    if (!options.bytesPerSecond) {
+        return remaining;
+    }
+
+    double rate = static_cast<double>(options.bytesPerSecond);
+    double elapsed = std::chrono::duration<double>(now - refilledAt).count();
+    refilledAt = now;
+    tokens = std::min(tokens + elapsed * rate, std::max(rate / 20, 1.0));
+    return std::min(remaining, static_cast<uint64_t>(tokens));
+}
+
+size_t LoopbackPty::Produce(char *data, size_t length) {
+    if (generator) {
+        generator->Fill(data, length);
+        produced += length;
+        return length;
+    }
+
+    size_t count = std::min(length, replay.size() - replayPosition);
+    std::memcpy(data, replay.data() + replayPosition, count);
+    replayPosition += count;
+    produced += count;
+    if (replayPosition == replay.size()) {
+        replayPasses++;
+        replayPosition = 0;
+    }
+    return count;
+}
+
+bool LoopbackPty::SourceDone() const {
+    switch (options.source) {
+    case backend::LoopbackOptions::Source::Echo:
+        return false;
+    case backend::LoopbackOptions::Source::Replay:
+        return replay.empty() || (options.loops && replayPasses >= options.loops);
+    default:
+        return options.totalBytes && produced >= options.totalBytes;
+    }
+}
+
+void LoopbackPty::Finish() {
+    LOG_DEBUG("Loopback PTY " << pid << " finished after " << produced << " bytes");
+    std::lock_guard<std::mutex> lock(exitMutex);
+    if (exitListener && !exitNotified) {
+        exitNotified = true;
+        exitListener->OnProcessExit(options.exitCode, 0);
+    }
+}
+
+bool LoopbackPty::Resize(int16_t cols, int16_t rows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) {
+        SetError(false);
+        return false;
+    }
+    this->cols = cols;
+    this->rows = rows;
+    return true;
+}
+
+void LoopbackPty::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    exited = true;
+    wake.notify_all();
+}
+
+bool LoopbackPty::IsActive() const {
+    return started && !exited.load();
+}
+
+uint32_t LoopbackPty::BytesAvailable() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t pending = input.size() - inputPosition;
+    if (!closed && !cancelled && !SourceDone() && options.source != backend::LoopbackOptions::Source::Echo) {
+        pending += options.bytesPerSecond ? static_cast<size_t>(std::max(tokens, 0.0)) : 65536;
+    }
+    return static_cast<uint32_t>(std::min<size_t>(pending, std::numeric_limits<uint32_t>::max()));
+}
+
+void LoopbackPty::CancelIo() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    wake.notify_all();
+}
+
+void LoopbackPty::ResumeIo() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = false;
+}
+
+bool LoopbackPty::WatchExit(backend::ExitListener *listener) {
+    std::lock_guard<std::mutex> lock(exitMutex);
+    if (exited.load() && !exitNotified) {
+        // Flux déjà épuisé avant la surveillance
+        exitNotified = true;
+        listener->OnProcessExit(options.exitCode, 0);
+        return true;
+    }
+    exitListener = listener;
+    return true;
+}
+
+void LoopbackPty::UnwatchExit() {
+    std::lock_guard<std::mutex> lock(exitMutex);
+    exitListener = nullptr;
+}
+
+} // namespace loopback
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pty_backend.h"
+#include "loopback/generator.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace loopback {
+
+// PTY sans processus pour les tests de charge et le fuzzing : la sortie
+// vient d'un enregistrement rejoué ou d'un générateur, à débit réglable,
+// et passe par le même ReadLoop/TSFN qu'un vrai PTY. L'entrée écrite est
+// renvoyée en sortie, comme l'écho d'un terminal. La fin du flux vaut
+// fin du processus (exitCode des options).
+class LoopbackPty : public backend::PtyBackend {
+public:
+    explicit LoopbackPty(const backend::LoopbackOptions &options);
+    ~LoopbackPty();
+
+    bool Create(int16_t cols, int16_t rows) override;
+    bool Start(const backend::SpawnOptions &options) override;
+    bool Write(const char *data, uint32_t length, uint32_t *written) override;
+    bool TryWrite(const char *data, uint32_t length, uint32_t *written) override;
+    bool Read(char *data, uint32_t length, uint32_t *read) override;
+    bool TryRead(char *data, uint32_t length, uint32_t *read) override;
+    bool Resize(int16_t cols, int16_t rows) override;
+    void Close() override;
+    bool IsActive() const override;
+    bool HasExited() override { return exited.load(); }
+    uint32_t GetProcessId() const override { return pid; }
+    uint32_t BytesAvailable() override;
+    void CancelIo() override;
+    void ResumeIo() override;
+    bool WatchExit(backend::ExitListener *listener) override;
+    void UnwatchExit() override;
+
+    // Écho en attente de relecture au-delà duquel TryWrite() refuse
+    static const size_t kMaxPendingInput = 1024 * 1024;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool ReadLocked(std::unique_lock<std::mutex> &lock, char *data, uint32_t length, uint32_t *read, bool wait);
+    // Octets de la source autorisés maintenant par le débit
+    uint64_t Allowance(Clock::time_point now);
+    size_t Produce(char *data, size_t length);
+    bool SourceDone() const;
+    void Finish();
+    bool LoadReplay();
+
+    backend::LoopbackOptions options;
+    std::unique_ptr<Generator> generator;
+    std::string replay;
+    size_t replayPosition;
+    uint32_t replayPasses;
+    uint64_t produced;
+
+    // Seau à jetons : au plus 50 ms de débit d'avance
+    double tokens;
+    Clock::time_point refilledAt;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Entrée renvoyée, relue à partir de inputPosition
+    std::string input;
+    size_t inputPosition;
+    bool started;
+    bool closed;
+    bool cancelled;
+    std::atomic<bool> exited;
+    int16_t cols;
+    int16_t rows;
+    uint32_t pid;
+
+    // Pris pendant OnProcessExit() pour que UnwatchExit() soit synchrone
+    std::mutex exitMutex;
+    backend::ExitListener *exitListener;
+    bool exitNotified;
+};
+
+} // namespace loopback
@@ -0,0 +1,60 @@
+#include "pty_backend.h"
+#include "loopback/loopback_pty.h"
+
+#ifdef _WIN32
+#include "win/conpty.h"
+#else
+#include "unix/unixpty.h"
+#include <cerrno>
+#include <cstdlib>
+#endif
+
+namespace backend {
+
+std::unique_ptr<PtyBackend> CreateDefault() {
+#ifdef _WIN32
+    return std::make_unique<conpty::ConPTY>();
+#else
+    return std::make_unique<unixpty::UnixPTY>();
+#endif
+}
+
+std::unique_ptr<PtyBackend> CreateLoopback(const LoopbackOptions &options) {
+    return std::make_unique<loopback::LoopbackPty>(options);
+}
+
+std::string DefaultShell() {
+#ifdef _WIN32
+    return "powershell.exe";
+#else
+    const char *shell = getenv("SHELL");
+    return (shell && *shell) ? shell : "/bin/sh";
+#endif
+}
+
+unsigned long LastError() {
+#ifdef _WIN32
+    return GetLastError();
+#else
+    return static_cast<unsigned long>(errno);
+#endif
+}
+
+bool IsNoDataError(unsigned long error) {
+#ifdef _WIN32
+    return error == ERROR_NO_DATA;
+#else
+    return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+#endif
+}
+
+bool IsBrokenPipeError(unsigned long error) {
+#ifdef _WIN32
+    return error == ERROR_BROKEN_PIPE;
+#else
+    // Linux renvoie EIO sur le maître une fois l'esclave fermé
+    return error == EIO || error == EPIPE;
+#endif
+}
+
+} // namespace backend
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace backend {
+
+// Fin du processus, notifiée une seule fois depuis un thread interne
+class ExitListener {
+public:
+    virtual ~ExitListener() {}
+    // signal vaut 0 si le processus est sorti de lui-même
+    virtual void OnProcessExit(int code, int signal) = 0;
+};
+
+// Faux PTY sans processus : la sortie vient d'un enregistrement ou d'un
+// générateur, l'entrée écrite est renvoyée telle quelle
+struct LoopbackOptions {
+    enum class Source { Echo, Replay, Text, Ansi, Fuzz };
+
+    Source source = Source::Echo;
+    // Replay : fichier (enregistrement NPTYREC1 ou octets bruts) ou données
+    std::string file;
+    std::string data;
+    // Octets par seconde, 0 sans limite
+    uint64_t bytesPerSecond = 0;
+    // Générateurs : volume total, 0 sans fin
+    uint64_t totalBytes = 0;
+    // Replay : nombre de passages, 0 sans fin
+    uint32_t loops = 1;
+    uint32_t seed = 1;
+    bool echo = true;
+    int exitCode = 0;
+};
+
+// Programme lancé dans le PTY
+struct SpawnOptions {
+    std::string file;
+    // Arguments après argv[0], qui vaut file
+    std::vector<std::string> args;
+    // Bloc "NOM=valeur\0...\0\0" construit une seule fois, vide pour
+    // hériter de l'environnement de Node
+    std::string environment;
+    // Vide : répertoire courant de Node
+    std::string cwd;
+    // Non nul : backend loopback au lieu d'un vrai PTY, file est ignoré
+    std::shared_ptr<const LoopbackOptions> loopback;
+
+    // Sans argument, environnement ni répertoire propres, un shell du pool convient
+    bool IsDefault() const { return args.empty() && environment.empty() && cwd.empty() && !loopback; }
+};
+
+// Interface commune aux pseudo-terminaux (ConPTY sous Windows, openpty ailleurs)
+class PtyBackend {
+public:
+    virtual ~PtyBackend() {}
+
+    virtual bool Create(int16_t cols, int16_t rows) = 0;
+    // Bloque jusqu'à l'exec, réussi ou non : à appeler hors du thread JS
+    virtual bool Start(const SpawnOptions &options) = 0;
+    virtual bool Write(const char *data, uint32_t length, uint32_t *written) = 0;
+    // Écrit ce qui passe sans attendre : échoue avec IsNoDataError() si le tampon est plein
+    virtual bool TryWrite(const char *data, uint32_t length, uint32_t *written) = 0;
+    virtual bool Read(char *data, uint32_t length, uint32_t *read) = 0;
+    // Comme Read() mais sans jamais attendre : échoue avec IsNoDataError() si vide
+    virtual bool TryRead(char *data, uint32_t length, uint32_t *read) = 0;
+    virtual bool Resize(int16_t cols, int16_t rows) = 0;
+    virtual void Close() = 0;
+    virtual bool IsActive() const = 0;
+    virtual bool HasExited() = 0;
+    virtual uint32_t GetProcessId() const = 0;
+
+    // Octets lisibles immédiatement, sans bloquer
+    virtual uint32_t BytesAvailable() = 0;
+
+    // Débloque définitivement les Read()/Write() en attente (fermeture du terminal)
+    virtual void CancelIo() {}
+    // Annule CancelIo() pour un nouveau propriétaire (terminal détaché)
+    virtual void ResumeIo() {}
+
+    // Descripteur surveillable par io::Reactor, -1 si le backend a besoin d'un thread
+    virtual int PollFd() const { return -1; }
+
+    // Surveille la fin du processus par évènement (pidfd, kqueue, attente
+    // Windows) ; false si la surveillance n'a pas pu être mise en place.
+    // Un processus déjà récolté est notifié avant le retour.
+    virtual bool WatchExit(ExitListener *listener) = 0;
+    // Synchrone : au retour, OnProcessExit() n'est plus en cours ni à venir
+    virtual void UnwatchExit() = 0;
+};
+
+std::unique_ptr<PtyBackend> CreateDefault();
+std::unique_ptr<PtyBackend> CreateLoopback(const LoopbackOptions &options);
+std::string DefaultShell();
+
+// Codes d'erreur système (GetLastError / errno)
+unsigned long LastError();
+bool IsNoDataError(unsigned long error);
+bool IsBrokenPipeError(unsigned long error);
+
+} // namespace backend
@@ -0,0 +1,65 @@
+#include "pty_handoff.h"
+#include "Logger/logger.h"
+#include <vector>
+
+namespace backend {
+
+PtyHandoff &PtyHandoff::Instance() {
+    // Jamais détruit : le Ticker peut encore l'appeler à la sortie
+    static PtyHandoff *handoff = new PtyHandoff();
+    return *handoff;
+}
+
+PtyHandoff::PtyHandoff() : nextToken(0) {
+}
+
+uint32_t PtyHandoff::Park(DetachedPty detached, std::chrono::milliseconds timeout) {
+    uint32_t token;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 0 n'est jamais distribué
+        do {
+            token = ++nextToken;
+        } while (token == 0 || parked.count(token) > 0);
+        Parked entry;
+        entry.detached = std::move(detached);
+        entry.deadline = std::chrono::steady_clock::now() + timeout;
+        parked.emplace(token, std::move(entry));
+    }
+    io::Ticker::Instance().Schedule(this, timeout);
+    return token;
+}
+
+bool PtyHandoff::Claim(uint32_t token, DetachedPty *detached) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = parked.find(token);
+    if (found == parked.end()) {
+        return false;
+    }
+    *detached = std::move(found->second.detached);
+    parked.erase(found);
+    return true;
+}
+
+void PtyHandoff::OnTick() {
+    std::vector<std::unique_ptr<PtyBackend>> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = parked.begin(); it != parked.end();) {
+            if (it->second.deadline <= now) {
+                expired.push_back(std::move(it->second.detached.pty));
+                it = parked.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // Hors verrou : la fermeture attend le processus
+    for (std::unique_ptr<PtyBackend> &pty : expired) {
+        LOG_WARNING("Detached PTY (PID " << pty->GetProcessId() << ") was not attached in time, closing it");
+        pty->Close();
+    }
+}
+
+} // namespace backend
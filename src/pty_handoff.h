@@ -0,0 +1,49 @@
+#pragma once
+#include "io/ticker.h"
+#include "pty_backend.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace backend {
+
+// PTY lâché par detach(), tel que attach() le reprend
+struct DetachedPty {
+    std::unique_ptr<PtyBackend> pty;
+    int16_t cols;
+    int16_t rows;
+};
+
+// PTY en transit d'un thread JS (worker) à un autre, commun à tout le
+// processus : le programme continue sans être relancé. Un PTY qui n'est
+// pas repris à temps est fermé.
+class PtyHandoff : private io::TickHandler {
+public:
+    static PtyHandoff &Instance();
+
+    // Jeton à transmettre au worker qui reprend le PTY
+    uint32_t Park(DetachedPty detached, std::chrono::milliseconds timeout);
+    // false si le jeton est inconnu, déjà repris ou expiré
+    bool Claim(uint32_t token, DetachedPty *detached);
+
+private:
+    struct Parked {
+        DetachedPty detached;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    PtyHandoff();
+    PtyHandoff(const PtyHandoff &) = delete;
+    PtyHandoff &operator=(const PtyHandoff &) = delete;
+
+    // Ferme les PTY expirés
+    void OnTick() override;
+
+    std::mutex mutex;
+    std::map<uint32_t, Parked> parked;
+    uint32_t nextToken;
+};
+
+} // namespace backend
@@ -0,0 +1,206 @@
+#include "pty_pool.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <thread>
+
+namespace backend {
+
+PtyPool &PtyPool::Instance() {
+    // Jamais détruit : les shells d'avance meurent avec le processus (SIGHUP)
+    static PtyPool *pool = new PtyPool();
+    return *pool;
+}
+
+PtyPool::PtyPool()
+    : size(0),
+      maxIdle(0),
+      generation(0),
+      running(false),
+      stats() {
+}
+
+void PtyPool::Configure(size_t count, std::chrono::milliseconds idleLimit,
+                        const std::vector<PtyPoolProfile> &profiles) {
+    std::deque<Slot> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        previous.swap(slots);
+        size = count;
+        maxIdle = idleLimit;
+        generation++;
+
+        if (size > 0) {
+            for (const PtyPoolProfile &profile : profiles) {
+                Slot slot;
+                slot.profile = profile;
+                // Les PTY déjà prêts pour le même profil sont gardés
+                for (Slot &old : previous) {
+                    if (old.profile.command == profile.command && old.profile.cols == profile.cols
+                        && old.profile.rows == profile.rows) {
+                        slot.idle.swap(old.idle);
+                        break;
+                    }
+                }
+                while (slot.idle.size() > size) {
+                    slot.idle.pop_back();
+                    stats.idle--;
+                }
+                slots.push_back(std::move(slot));
+            }
+        }
+        for (Slot &old : previous) {
+            stats.idle -= old.idle.size();
+        }
+
+        if (!slots.empty() && !running) {
+            running = true;
+            std::thread([this]() { this->Run(); }).detach();
+        } else {
+            wake.notify_one();
+        }
+    }
+    // previous ferme ici, hors verrou, les PTY qui ne servent plus
+}
+
+std::unique_ptr<PtyBackend> PtyPool::Acquire(const std::string &command, int16_t cols, int16_t rows) {
+    std::unique_ptr<PtyBackend> pty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (slots.empty()) {
+            return nullptr;
+        }
+
+        // Taille exacte de préférence : pas de SIGWINCH au démarrage
+        Slot *match = nullptr;
+        for (Slot &slot : slots) {
+            if (slot.profile.command != command || slot.idle.empty()) {
+                continue;
+            }
+            if (!match || (slot.profile.cols == cols && slot.profile.rows == rows)) {
+                match = &slot;
+            }
+        }
+        if (!match) {
+            stats.misses++;
+            return nullptr;
+        }
+
+        pty = std::move(match->idle.front().pty);
+        match->idle.pop_front();
+        stats.idle--;
+        wake.notify_one();
+    }
+
+    // Un shell mort entre-temps (tué de l'extérieur) ne sert à rien
+    if (pty->HasExited()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.misses++;
+        return nullptr;
+    }
+    if (!pty->Resize(cols, rows)) {
+        LOG_WARNING("Pooled PTY resize to " << cols << "x" << rows << " failed");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.hits++;
+    return pty;
+}
+
+PtyPoolStats PtyPool::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::unique_ptr<PtyBackend> PtyPool::Spawn(const PtyPoolProfile &profile) {
+    SpawnOptions options;
+    options.file = profile.command;
+
+    std::unique_ptr<PtyBackend> pty = CreateDefault();
+    if (!pty->Create(profile.cols, profile.rows) || !pty->Start(options)) {
+        LOG_WARNING("Pool failed to start " << profile.command << ": " << LastError());
+        return nullptr;
+    }
+    return pty;
+}
+
+void PtyPool::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!slots.empty()) {
+        auto now = std::chrono::steady_clock::now();
+        auto next = now + std::chrono::seconds(1);
+
+        // Les PTY trop vieux ou dont le shell est mort sont fermés hors verrou
+        std::vector<std::unique_ptr<PtyBackend>> retired;
+        for (Slot &slot : slots) {
+            for (auto it = slot.idle.begin(); it != slot.idle.end();) {
+                bool expired = maxIdle.count() > 0 && now - it->since >= maxIdle;
+                if (expired || it->pty->HasExited()) {
+                    retired.push_back(std::move(it->pty));
+                    it = slot.idle.erase(it);
+                    stats.idle--;
+                    stats.expired++;
+                } else {
+                    if (maxIdle.count() > 0) {
+                        next = std::min(next, it->since + maxIdle);
+                    }
+                    ++it;
+                }
+            }
+        }
+        if (!retired.empty()) {
+            lock.unlock();
+            retired.clear();
+            lock.lock();
+            continue;
+        }
+
+        // Un seul lancement à la fois, pour le profil le plus dégarni
+        Slot *target = nullptr;
+        for (Slot &slot : slots) {
+            if (slot.idle.size() < size && (!target || slot.idle.size() < target->idle.size())) {
+                target = &slot;
+            }
+        }
+        if (!target) {
+            wake.wait_until(lock, next);
+            continue;
+        }
+
+        PtyPoolProfile profile = target->profile;
+        uint64_t startedGeneration = generation;
+        lock.unlock();
+        std::unique_ptr<PtyBackend> pty = Spawn(profile);
+        lock.lock();
+
+        if (!pty) {
+            stats.failed++;
+            // Pas de boucle de fork() si la commande est invalide
+            wake.wait_for(lock, std::chrono::seconds(1));
+            continue;
+        }
+        stats.spawned++;
+
+        if (generation != startedGeneration) {
+            // Reconfiguré pendant le lancement : le profil existe-t-il encore ?
+            target = nullptr;
+            for (Slot &slot : slots) {
+                if (slot.profile.command == profile.command && slot.profile.cols == profile.cols
+                    && slot.profile.rows == profile.rows) {
+                    target = &slot;
+                    break;
+                }
+            }
+            if (!target || target->idle.size() >= size) {
+                lock.unlock();
+                pty.reset();
+                lock.lock();
+                continue;
+            }
+        }
+        target->idle.push_back(Idle{std::move(pty), std::chrono::steady_clock::now()});
+        stats.idle++;
+    }
+    running = false;
+}
+
+} // namespace backend
@@ -0,0 +1,78 @@
+#pragma once
+#include "pty_backend.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace backend {
+
+// Commande et taille avec lesquelles les shells d'avance sont lancés
+struct PtyPoolProfile {
+    std::string command;
+    int16_t cols;
+    int16_t rows;
+};
+
+struct PtyPoolStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t spawned;
+    uint64_t expired;
+    uint64_t failed;
+    size_t idle;
+};
+
+// Réserve de PTY dont le shell est déjà lancé (profil exécuté) : un
+// startProcess() en prend un tout prêt, et un thread de fond le remplace.
+// Le thread n'existe que tant que le pool est configuré.
+class PtyPool {
+public:
+    static PtyPool &Instance();
+
+    // size PTY par profil ; ceux inutilisés depuis maxIdle sont relancés
+    // (0 : jamais). size == 0 vide et désactive le pool.
+    void Configure(size_t size, std::chrono::milliseconds maxIdle, const std::vector<PtyPoolProfile> &profiles);
+
+    // PTY prêt pour command, redimensionné à cols x rows ; nullptr si le
+    // pool n'en a pas
+    std::unique_ptr<PtyBackend> Acquire(const std::string &command, int16_t cols, int16_t rows);
+
+    PtyPoolStats GetStats();
+
+private:
+    struct Idle {
+        std::unique_ptr<PtyBackend> pty;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct Slot {
+        PtyPoolProfile profile;
+        std::deque<Idle> idle;
+    };
+
+    PtyPool();
+    PtyPool(const PtyPool &) = delete;
+    PtyPool &operator=(const PtyPool &) = delete;
+
+    void Run();
+    static std::unique_ptr<PtyBackend> Spawn(const PtyPoolProfile &profile);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Slot> slots;
+    size_t size;
+    std::chrono::milliseconds maxIdle;
+    // Change à chaque Configure() : un lancement en cours pour une ancienne
+    // configuration est jeté
+    uint64_t generation;
+    bool running;
+    PtyPoolStats stats;
+};
+
+} // namespace backend
@@ -0,0 +1,94 @@
+#include "stats.h"
+#include <algorithm>
+
+namespace stats {
+
+LatencyHistogram::LatencyHistogram() : sum(0) {
+    for (std::atomic<uint64_t> &count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && UpperBound(bucket) < micros) {
+        bucket++;
+    }
+    Bump(counts[bucket]);
+    Bump(sum, micros);
+}
+
+void LatencyHistogram::AddTo(Snapshot *snapshot) const {
+    for (int i = 0; i < kBuckets; i++) {
+        uint64_t count = counts[i].load(std::memory_order_relaxed);
+        snapshot->latencyBuckets[i] += count;
+        snapshot->latencyCount += count;
+    }
+    snapshot->latencySumMicros += sum.load(std::memory_order_relaxed);
+}
+
+void TerminalCounters::Enqueued() {
+    int64_t depth = queueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    int64_t peak = peakQueueDepth.load(std::memory_order_relaxed);
+    while (depth > peak && !peakQueueDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+    }
+}
+
+void TerminalCounters::AddTo(Snapshot *snapshot) const {
+    snapshot->bytesRead += bytesRead.load(std::memory_order_relaxed);
+    snapshot->readCalls += readCalls.load(std::memory_order_relaxed);
+    snapshot->bytesWritten += bytesWritten.load(std::memory_order_relaxed);
+    snapshot->writeCalls += writeCalls.load(std::memory_order_relaxed);
+    snapshot->writeStalls += writeStalls.load(std::memory_order_relaxed);
+    snapshot->callbacks += callbacks.load(std::memory_order_relaxed);
+    snapshot->throttles += throttles.load(std::memory_order_relaxed);
+    snapshot->resizes += resizes.load(std::memory_order_relaxed);
+    snapshot->framedBytes += framedBytes.load(std::memory_order_relaxed);
+    snapshot->queueDepth += queueDepth.load(std::memory_order_relaxed);
+    snapshot->peakQueueDepth = std::max(snapshot->peakQueueDepth, peakQueueDepth.load(std::memory_order_relaxed));
+    latency.AddTo(snapshot);
+}
+
+double TerminalCounters::ProcessLifetimeMs() const {
+    int64_t started = processStarted.load(std::memory_order_relaxed);
+    if (started == 0) {
+        return 0;
+    }
+    int64_t ended = processEnded.load(std::memory_order_relaxed);
+    return static_cast<double>((ended != 0 ? ended : NowNs()) - started) / 1e6;
+}
+
+Registry &Registry::Instance() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+Registry::Registry() : created(0) {
+}
+
+void Registry::Add(TerminalCounters *counters) {
+    std::lock_guard<std::mutex> lock(mutex);
+    terminals.push_back(counters);
+    created++;
+}
+
+void Registry::Remove(TerminalCounters *counters) {
+    std::lock_guard<std::mutex> lock(mutex);
+    terminals.erase(std::remove(terminals.begin(), terminals.end(), counters), terminals.end());
+    counters->AddTo(&retired);
+    // Les blocs encore en file ne comptent plus dans la profondeur courante
+    retired.queueDepth = 0;
+}
+
+Snapshot Registry::Aggregate(size_t *live, uint64_t *createdCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Snapshot snapshot = retired;
+    for (TerminalCounters *counters : terminals) {
+        counters->AddTo(&snapshot);
+    }
+    *live = terminals.size();
+    *createdCount = created;
+    return snapshot;
+}
+
+} // namespace stats
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace stats {
+
+// Compteurs mis à jour sans ordre mémoire (relaxed) depuis les threads de
+// lecture/écriture et le thread JS ; une lecture peut donc mélanger deux
+// instants, ce qui suffit pour de la supervision.
+inline void Bump(std::atomic<uint64_t> &counter, uint64_t value = 1) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Horloge monotone en ns, pour les horodatages stockés dans des atomiques
+inline int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Snapshot;
+
+// Histogramme à seaux en puissances de 2 (1 µs à ~8 s)
+class LatencyHistogram {
+public:
+    static const int kBuckets = 24;
+
+    LatencyHistogram();
+
+    void Record(uint64_t micros);
+    void AddTo(Snapshot *snapshot) const;
+
+    // Borne haute du seau en µs
+    static uint64_t UpperBound(int bucket) { return 1ull << bucket; }
+
+private:
+    std::atomic<uint64_t> counts[kBuckets];
+    std::atomic<uint64_t> sum;
+};
+
+struct Snapshot {
+    uint64_t bytesRead = 0;
+    uint64_t readCalls = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t writeCalls = 0;
+    uint64_t writeStalls = 0;
+    uint64_t callbacks = 0;
+    uint64_t throttles = 0;
+    uint64_t resizes = 0;
+    uint64_t framedBytes = 0;
+    int64_t queueDepth = 0;
+    int64_t peakQueueDepth = 0;
+    uint64_t latencyCount = 0;
+    uint64_t latencySumMicros = 0;
+    uint64_t latencyBuckets[LatencyHistogram::kBuckets] = {};
+};
+
+struct TerminalCounters {
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> readCalls{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> writeCalls{0};
+    // Écritures non bloquantes refusées ou partielles (PTY plein)
+    std::atomic<uint64_t> writeStalls{0};
+    std::atomic<uint64_t> callbacks{0};
+    std::atomic<uint64_t> throttles{0};
+    std::atomic<uint64_t> resizes{0};
+    // Octets des trames binaires livrées à onData (après compression)
+    std::atomic<uint64_t> framedBytes{0};
+    // Blocs de sortie postés à JS et pas encore livrés
+    std::atomic<int64_t> queueDepth{0};
+    std::atomic<int64_t> peakQueueDepth{0};
+    // De la lecture du PTY à l'appel du callback JS
+    LatencyHistogram latency;
+    // Démarrage et fin de sortie du processus (NowNs(), 0 si pas encore)
+    std::atomic<int64_t> processStarted{0};
+    std::atomic<int64_t> processEnded{0};
+
+    void Enqueued();
+    void Dequeued() { queueDepth.fetch_sub(1, std::memory_order_relaxed); }
+    void AddTo(Snapshot *snapshot) const;
+    // Durée de vie du processus en ms, arrêtée à sa fin de sortie
+    double ProcessLifetimeMs() const;
+};
+
+// Agrégat du module : terminaux vivants plus les totaux de ceux détruits
+class Registry {
+public:
+    static Registry &Instance();
+
+    void Add(TerminalCounters *counters);
+    void Remove(TerminalCounters *counters);
+    Snapshot Aggregate(size_t *live, uint64_t *created);
+
+private:
+    Registry();
+
+    std::mutex mutex;
+    std::vector<TerminalCounters *> terminals;
+    Snapshot retired;
+    uint64_t created;
+};
+
+} // namespace stats
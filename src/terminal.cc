@@ -1,283 +1,2850 @@
 #include "terminal.h"
-#include "win/conpty.h"
-#include <iostream>
+#include "pty_backend.h"
+#include "pty_handoff.h"
+#include "pty_pool.h"
+#include "io/buffer_pool.h"
+#include "io/frame_encoder.h"
+#include "io/reactor.h"
+#include "io/recorder.h"
+#include "io/shared_ring.h"
+#include "vt/framing.h"
+#include "vt/utf8.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <mutex>
 #include <thread>
 #include <vector>
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+
+static const uint32_t kMinReadSize = 1024;
+static const uint32_t kMaxReadSize = 64 * 1024;
+static const size_t kInputHighWater = 1024 * 1024;
+static const size_t kDefaultScrollback = 1024 * 1024;
+static const int kMaxFramesInFlight = 2;
+static const size_t kMaxReadyBuffer = 4096;
+static const std::chrono::milliseconds kResizeWindow(50);
+static const char kPasteStart[] = "\x1b[200~";
+static const char kPasteEnd[] = "\x1b[201~";
+// Un motif retenu en fin de bloc ne doit pas immobiliser trop de sortie, et
+// la taille de l'automate suit le total des motifs
+static const size_t kMaxTriggerLength = 1024;
+static const size_t kMaxTriggerBytes = 16 * 1024;
 
 WebTerminal::WebTerminal(const Napi::CallbackInfo &info)
     : Napi::ObjectWrap<WebTerminal>(info),
       pty(nullptr),
       running(false),
       initialized(false),
-      processId(0)
+      processId(0),
+      channel(nullptr),
+      eventChannel(nullptr),
+      hasCallback(false),
+      ioStarted(false),
+      outputFinished(false),
+      starting(false),
+      readyMode(ReadyMode::Exec),
+      childExited(false),
+      exitReported(false),
+      outputDone(false),
+      exitFired(false),
+      tornDown(false),
+      detached(false),
+      envClosed(false),
+      exitCode(0),
+      exitSignal(0),
+      registration(nullptr),
+      paused(false),
+      throttled(false),
+      readClosed(false),
+      queuedBytes(0),
+      maxQueuedBytes(4 * 1024 * 1024),
+      coalesceLatency(std::chrono::milliseconds(0)),
+      coalesceMaxBatch(64 * 1024),
+      framing(true),
+      readSize(kMinReadSize),
+      shortReads(0),
+      pending(nullptr),
+      inputFailed(false),
+      drainWanted(false),
+      bytesWritten(0),
+      nextWriteCallback(UINT64_MAX),
+      resizeScheduled(false),
+      pendingCols(0),
+      pendingRows(0),
+      appliedCols(0),
+      appliedRows(0),
+      scrollback(kDefaultScrollback),
+      subscriberCount(0),
+      nextSubscriberId(0),
+      subscribersClosed(false),
+      hasRing(false),
+      nextTriggerId(0),
+      triggersVersion(0),
+      activeTriggersVersion(0),
+      triggerScanned(0),
+      frameChannel(nullptr),
+      hasFrameCallback(false),
+      framesInFlight(0)
+{
+    LOG_DEBUG("Terminal constructor called");
+    Napi::Env env = info.Env();
+    resizeTimer.owner = this;
+
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("scrollback"))
+        {
+            double bytes = options.Get("scrollback").As<Napi::Number>().DoubleValue();
+            if (bytes < 0)
+            {
+                throw Napi::RangeError::New(env, "scrollback must not be negative");
+            }
+            scrollback.SetCapacity(static_cast<size_t>(bytes));
+        }
+        if (options.Has("record"))
+        {
+            std::string path = options.Get("record").ToString().Utf8Value();
+            recorder.reset(new io::Recorder());
+            if (!recorder->Open(path))
+            {
+                int error = errno;
+                recorder.reset();
+                throw Napi::Error::New(env, "Failed to open recording " + path + ": " + strerror(error));
+            }
+        }
+        if (options.Has("screen") && options.Get("screen").ToBoolean())
+        {
+            emulator.reset(new vt::Emulator(120, 30));
+        }
+    }
+
+    pty = backend::CreateDefault();
+
+    // Canal des évènements natifs (fin d'écriture, drain). Il ne retient pas
+    // la boucle d'évènements de Node.
+    eventChannel = new EventChannel();
+    eventChannel->owner = this;
+    events = EventFunction::New(
+        env,
+        "Terminal Events",
+        0,
+        1,
+        eventChannel,
+        [](Napi::Env, EventChannel* channel) {
+            if (channel->owner)
+            {
+                channel->owner->eventChannel = nullptr;
+            }
+            delete channel;
+        });
+    events.Unref(env);
+
+    // Un worker qui se termine arrête ses terminaux pendant que son isolat existe encore
+    if (napi_add_env_cleanup_hook(env, &WebTerminal::OnEnvCleanup, this) != napi_ok)
+    {
+        envClosed = true;
+        LOG_WARNING("Failed to register environment cleanup hook");
+    }
+
+    stats::Registry::Instance().Add(&counters);
+}
+
+void WebTerminal::OnEnvCleanup(void* arg)
+{
+    WebTerminal* terminal = static_cast<WebTerminal*>(arg);
+    terminal->envClosed = true;
+    terminal->Teardown();
+}
+
+WebTerminal::~WebTerminal()
+{
+    LOG_DEBUG("Terminal destructor called");
+    if (!envClosed)
+    {
+        napi_remove_env_cleanup_hook(Env(), &WebTerminal::OnEnvCleanup, this);
+    }
+    Teardown();
+    if (channel)
+    {
+        // Les blocs encore en file seront livrés sans repasser par ce terminal
+        channel->owner = nullptr;
+    }
+    if (eventChannel)
+    {
+        eventChannel->owner = nullptr;
+    }
+    {
+        // Déjà relâchés par FinishOutput() : leurs derniers blocs se passent du terminal
+        std::lock_guard<std::mutex> lock(subscribersMutex);
+        for (Subscriber* subscriber : subscribers)
+        {
+            subscriber->owner = nullptr;
+        }
+    }
+    events.Release();
+    stats::Registry::Instance().Remove(&counters);
+}
+
+// Arrête les E/S et ferme le PTY ; appelé à la fin du processus ou à la
+// destruction, selon ce qui arrive en premier
+void WebTerminal::Teardown()
+{
+    if (tornDown)
+    {
+        return;
+    }
+    tornDown = true;
+    if (pty)
+    {
+        // Plus de OnProcessExit() après ceci : registration peut disparaître
+        pty->UnwatchExit();
+    }
+    StopIo();
+    if (pty)
+    {
+        pty->Close();
+    }
+}
+
+// Arrête lecture, écriture et minuteries puis livre ce qui a été lu ; le
+// PTY reste ouvert (Teardown() le ferme, Detach() le passe à un autre)
+void WebTerminal::StopIo()
+{
+    running = false;
+    if (hasFrameCallback)
+    {
+        io::Ticker::Instance().Remove(this);
+    }
+    io::Ticker::Instance().Remove(&resizeTimer);
+    {
+        std::lock_guard<std::mutex> lock(flowMutex);
+        flowCv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        writeCv.notify_all();
+    }
+    if (registration)
+    {
+        // Attend la fin d'un éventuel OnReadable() en cours sur le réacteur
+        io::Reactor::Instance().Unregister(registration);
+        registration = nullptr;
+    }
+    if (pty)
+    {
+        pty->CancelIo();
+    }
+    if (readThread.joinable())
+    {
+        readThread.join();
+    }
+    if (writeThread.joinable())
+    {
+        writeThread.join();
+    }
+    FinishOutput();
+    if (recorder)
+    {
+        // Écrit ce qui reste en file puis ferme les fichiers
+        recorder->Close();
+    }
+    if (hasFrameCallback)
+    {
+        if (frameChannel)
+        {
+            frameChannel->owner = nullptr;
+        }
+        frames.Release();
+        hasFrameCallback = false;
+    }
+}
+
+Napi::Object WebTerminal::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::Function func = DefineClass(env, "WebTerminal", {
+        InstanceMethod("startProcess", &WebTerminal::StartProcess),
+        InstanceMethod("write", &WebTerminal::Write),
+        InstanceMethod("paste", &WebTerminal::Paste),
+        InstanceMethod("onData", &WebTerminal::OnData),
+        InstanceMethod("onDrain", &WebTerminal::OnDrain),
+        InstanceMethod("onFrame", &WebTerminal::OnFrame),
+        InstanceMethod("onExit", &WebTerminal::OnExit),
+        InstanceMethod("subscribe", &WebTerminal::Subscribe),
+        InstanceMethod("unsubscribe", &WebTerminal::Unsubscribe),
+        InstanceMethod("setOutputRing", &WebTerminal::SetOutputRing),
+        InstanceMethod("addTrigger", &WebTerminal::AddTrigger),
+        InstanceMethod("removeTrigger", &WebTerminal::RemoveTrigger),
+        InstanceMethod("resize", &WebTerminal::Resize),
+        InstanceMethod("echo", &WebTerminal::Echo),
+        InstanceMethod("pause", &WebTerminal::Pause),
+        InstanceMethod("resume", &WebTerminal::Resume),
+        InstanceMethod("getQueuedBytes", &WebTerminal::GetQueuedBytes),
+        InstanceMethod("getScrollback", &WebTerminal::GetScrollback),
+        InstanceMethod("exportSnapshot", &WebTerminal::ExportSnapshot),
+        InstanceMethod("importSnapshot", &WebTerminal::ImportSnapshot),
+        InstanceMethod("getStats", &WebTerminal::GetStats),
+        InstanceMethod("detach", &WebTerminal::Detach),
+        InstanceMethod("attach", &WebTerminal::Attach)});
+
+    Napi::FunctionReference *constructor = new Napi::FunctionReference();
+    *constructor = Napi::Persistent(func);
+    env.SetInstanceData(constructor);
+
+    exports.Set("WebTerminal", func);
+    return exports;
+}
+
+// Bloc d'environnement "NOM=valeur\0...\0\0" construit en une passe,
+// transmis tel quel à l'exec (ou converti d'un bloc en UTF-16 sous Windows)
+static std::string BuildEnvironment(Napi::Env env, Napi::Object vars) {
+    std::string block;
+    Napi::Array names = vars.GetPropertyNames();
+    for (uint32_t i = 0; i < names.Length(); i++) {
+        Napi::Value name = names.Get(i);
+        Napi::Value value = vars.Get(name);
+        if (value.IsUndefined() || value.IsNull()) {
+            continue;
+        }
+        std::string key = name.ToString().Utf8Value();
+        std::string text = value.ToString().Utf8Value();
+        if (key.empty() || key.find('=') != std::string::npos
+            || key.find('\0') != std::string::npos || text.find('\0') != std::string::npos) {
+            throw Napi::TypeError::New(env, "Invalid environment variable: " + key);
+        }
+        block.append(key).append(1, '=').append(text).append(1, '\0');
+    }
+    // Fin du bloc, même pour un environnement vide
+    block.append(1, '\0');
+    return block;
+}
+
+// Options de startProcess({ loopback }) : faux PTY pour les tests de charge
+static std::shared_ptr<const backend::LoopbackOptions> ParseLoopback(Napi::Env env, Napi::Value value) {
+    using Source = backend::LoopbackOptions::Source;
+    auto loopback = std::make_shared<backend::LoopbackOptions>();
+    if (value.IsBoolean() && value.As<Napi::Boolean>().Value()) {
+        return loopback;
+    }
+    if (!value.IsObject()) {
+        throw Napi::TypeError::New(env, "loopback must be true or an object");
+    }
+    Napi::Object options = value.As<Napi::Object>();
+
+    if (options.Has("source")) {
+        std::string source = options.Get("source").ToString().Utf8Value();
+        if (source == "echo") {
+            loopback->source = Source::Echo;
+        } else if (source == "replay") {
+            loopback->source = Source::Replay;
+        } else if (source == "text") {
+            loopback->source = Source::Text;
+        } else if (source == "ansi") {
+            loopback->source = Source::Ansi;
+        } else if (source == "fuzz") {
+            loopback->source = Source::Fuzz;
+        } else {
+            throw Napi::TypeError::New(env, "loopback.source must be 'echo', 'replay', 'text', 'ansi' or 'fuzz'");
+        }
+    }
+    if (options.Has("file")) {
+        if (!options.Get("file").IsString()) {
+            throw Napi::TypeError::New(env, "loopback.file must be a string");
+        }
+        loopback->file = options.Get("file").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("data")) {
+        Napi::Value data = options.Get("data");
+        if (data.IsBuffer()) {
+            Napi::Buffer<char> buffer = data.As<Napi::Buffer<char>>();
+            loopback->data.assign(buffer.Data(), buffer.Length());
+        } else if (data.IsString()) {
+            loopback->data = data.As<Napi::String>().Utf8Value();
+        } else {
+            throw Napi::TypeError::New(env, "loopback.data must be a Buffer or a string");
+        }
+    }
+    if (loopback->source == Source::Replay && loopback->file.empty() && loopback->data.empty()) {
+        throw Napi::TypeError::New(env, "loopback replay needs a file or data");
+    }
+
+    auto count = [&](const char* name) -> double {
+        Napi::Value number = options.Get(name);
+        if (!number.IsNumber() || number.As<Napi::Number>().DoubleValue() < 0) {
+            throw Napi::TypeError::New(env, std::string("loopback.") + name + " must be a non-negative number");
+        }
+        return number.As<Napi::Number>().DoubleValue();
+    };
+    if (options.Has("rate")) {
+        loopback->bytesPerSecond = static_cast<uint64_t>(count("rate"));
+    }
+    if (options.Has("bytes")) {
+        loopback->totalBytes = static_cast<uint64_t>(count("bytes"));
+    }
+    if (options.Has("loops")) {
+        loopback->loops = static_cast<uint32_t>(std::min(count("loops"), 4294967295.0));
+    }
+    if (options.Has("seed")) {
+        loopback->seed = static_cast<uint32_t>(options.Get("seed").ToNumber().Int64Value());
+    }
+    if (options.Has("echo")) {
+        loopback->echo = options.Get("echo").ToBoolean().Value();
+    }
+    if (options.Has("exitCode")) {
+        loopback->exitCode = options.Get("exitCode").ToNumber().Int32Value();
+    }
+    return loopback;
+}
+
+// Chaîne JS pour le mode encoding: 'utf8'. Les morceaux se terminent sur
+// une frontière de caractère (FlushPending), la validation ne remplace donc
+// que des octets réellement invalides.
+static Napi::Value DecodeOutput(Napi::Env env, const char* data, size_t size) {
+    vt::Utf8Check check = vt::ValidateUtf8(data, size);
+    if (check.ascii) {
+        // ASCII pur : V8 crée directement une chaîne à un octet par caractère
+        napi_value value;
+        if (napi_create_string_latin1(env, data, size, &value) == napi_ok) {
+            return Napi::Value(env, value);
+        }
+    }
+    if (check.valid) {
+        return Napi::String::New(env, data, size);
+    }
+
+    std::string sanitized;
+    vt::AppendSanitizedUtf8(data, size, &sanitized);
+    return Napi::String::New(env, sanitized);
+}
+
+// Le bloc est prêté à JS et rendu au pool quand le Buffer est collecté
+static Napi::Buffer<char> LendBlock(Napi::Env env, io::Block* block) {
+    Napi::MemoryManagement::AdjustExternalMemory(env, block->capacity);
+    return Napi::Buffer<char>::NewOrCopy(
+        env, block->data, block->size,
+        [](Napi::Env env, char*, io::Block* block) {
+            Napi::MemoryManagement::AdjustExternalMemory(env, -static_cast<int64_t>(block->capacity));
+            io::BufferPool::Instance().Release(block);
+        },
+        block);
+}
+
+void OutputChannel::Deliver(Napi::Env env, Napi::Function callback, OutputChannel* channel, io::Block* block) {
+    if (!block) return;
+
+    // Comptées dès la sortie de la file, même si le callback JS lève une exception
+    WebTerminal* owner = channel->owner;
+    if (owner) {
+        owner->OnOutputDelivered(block->size);
+    }
+
+    if (env == nullptr || callback.IsEmpty()) {
+        io::BufferPool::Instance().Release(block);
+        return;
+    }
+
+    if (owner && owner->startDeferred) {
+        owner->CheckReady(env, block->data, block->size);
+    }
+    if (owner) {
+        int64_t latency = stats::NowNs() - block->readAt;
+        owner->counters.latency.Record(latency > 0 ? static_cast<uint64_t>(latency) / 1000 : 0);
+        stats::Bump(owner->counters.callbacks);
+    }
+
+    if (channel->utf8) {
+        Napi::Value text = DecodeOutput(env, block->data, block->size);
+        io::BufferPool::Instance().Release(block);
+        callback.Call({text});
+        return;
+    }
+
+    callback.Call({LendBlock(env, block)});
+}
+
+void WebTerminal::SendOutput(io::Block* block, std::chrono::steady_clock::time_point readAt) {
+    size_t size = block->size;
+    block->readAt = std::chrono::duration_cast<std::chrono::nanoseconds>(readAt.time_since_epoch()).count();
+    FanOut(block);
+    if (emulator) {
+        emulator->Feed(block->data, size);
+    }
+    if (recorder) {
+        recorder->RecordOutput(block);
+    }
+    if (!hasCallback.load()) {
+        // Seulement des abonnés : ils ont pris leurs références
+        io::BufferPool::Instance().Release(block);
+        return;
+    }
+
+    if (frameEncoder) {
+        // Compression ici, hors du thread JS ; le bloc brut a déjà servi
+        // à l'historique, aux abonnés et au modèle d'écran
+        for (size_t done = 0; done < size;) {
+            size_t piece = std::min(size - done, io::FrameEncoder::kMaxPayload);
+            io::Block* frame = frameEncoder->Encode(block->data + done, piece, block->offset + done);
+            if (!frame) {
+                LOG_ERROR("Output frame encoding failed, dropping " << size - done << " bytes");
+                break;
+            }
+            frame->readAt = block->readAt;
+            stats::Bump(counters.framedBytes, frame->size);
+            PostOutput(frame);
+            done += piece;
+        }
+        io::BufferPool::Instance().Release(block);
+        return;
+    }
+    PostOutput(block);
+}
+
+void WebTerminal::PostOutput(io::Block* block) {
+    size_t size = block->size;
+    queuedBytes += size;
+
+    counters.Enqueued();
+    if (tsfn.NonBlockingCall(block) != napi_ok) {
+        counters.Dequeued();
+        queuedBytes -= size;
+        io::BufferPool::Instance().Release(block);
+        return;
+    }
+
+    if (queuedBytes.load() >= maxQueuedBytes) {
+        // JS ne suit plus : on cesse de lire, le tampon noyau du PTY
+        // se remplit et finit par bloquer le processus fils.
+        throttled = true;
+        stats::Bump(counters.throttles);
+        if (queuedBytes.load() < maxQueuedBytes / 2) {
+            // Vidé entre-temps par OnOutputDelivered(), qui n'a pas vu le drapeau
+            throttled = false;
+        }
+    }
+}
+
+void WebTerminal::OnOutputDelivered(size_t size) {
+    counters.Dequeued();
+    size_t remaining = queuedBytes -= size;
+    if (throttled.load() && remaining < maxQueuedBytes / 2) {
+        throttled = false;
+        UpdateReading();
+    }
+}
+
+bool WebTerminal::HasReaders() const {
+    return hasCallback.load() || subscriberCount.load() > 0 || hasRing.load();
+}
+
+bool WebTerminal::WantsRead() {
+    // Seul onData freine la lecture : un abonné lent décroche (FanOut)
+    return HasReaders() && !readClosed.load() && !paused.load() && !throttled.load();
+}
+
+// Historique puis abonnés sous le même verrou, que CatchUpLocked() prend aussi
+void WebTerminal::FanOut(io::Block* block) {
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    block->offset = scrollback.End();
+    scrollback.Append(block->data, block->size);
+
+    if (ring) {
+        ring->Write(block->data, block->size);
+        if (ring->TakeWaiter()) {
+            PostEvent(TerminalEvent::RingWake, 0);
+        }
+    }
+
+    for (Subscriber* subscriber : subscribers) {
+        if (subscriber->closed || subscriber->lagging.load()) {
+            continue;
+        }
+        size_t queued = subscriber->queuedBytes.load();
+        if (queued > 0 && queued + block->size > subscriber->maxQueuedBytes) {
+            subscriber->lagging = true;
+            queued = subscriber->queuedBytes.load();
+            if (queued > 0 && queued + block->size > subscriber->maxQueuedBytes) {
+                continue;
+            }
+            // Vidé entre-temps par Subscriber::Deliver(), qui n'a pas vu le drapeau
+            subscriber->lagging = false;
+        }
+
+        io::BufferPool::Retain(block);
+        subscriber->queuedBytes += block->size;
+        if (subscriber->tsfn.NonBlockingCall(block) != napi_ok) {
+            subscriber->queuedBytes -= block->size;
+            io::BufferPool::Instance().Release(block);
+            continue;
+        }
+        subscriber->cursor = block->offset + block->size;
+    }
+}
+
+void WebTerminal::CatchUp(Subscriber* subscriber) {
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    CatchUpLocked(subscriber);
+}
+
+// Relit l'historique depuis le curseur de l'abonné, par lots d'au plus la
+// moitié de son budget. Ce qui a déjà été écrasé est sauté : l'offset passé
+// au callback le montre.
+void WebTerminal::CatchUpLocked(Subscriber* subscriber) {
+    if (subscriber->closed || !subscriber->lagging.load()) {
+        return;
+    }
+
+    io::BufferPool& pool = io::BufferPool::Instance();
+    size_t budget = std::max<size_t>(subscriber->maxQueuedBytes / 2, 1);
+    while (budget > 0) {
+        size_t available = std::min(scrollback.Available(subscriber->cursor), budget);
+        if (available == 0) {
+            subscriber->lagging = false;
+            return;
+        }
+
+        io::Block* block = pool.Acquire(available);
+        uint64_t start;
+        size_t copied = scrollback.Read(subscriber->cursor, block->data, std::min<size_t>(available, block->capacity), &start);
+        block->size = static_cast<uint32_t>(copied);
+        block->offset = start;
+        block->readAt = stats::NowNs();
+
+        subscriber->queuedBytes += copied;
+        if (subscriber->tsfn.NonBlockingCall(block) != napi_ok) {
+            subscriber->queuedBytes -= copied;
+            pool.Release(block);
+            return;
+        }
+        subscriber->cursor = start + copied;
+        budget -= copied;
+    }
+}
+
+// Fin de la sortie : les abonnés reçoivent ce qui est en file puis sont finalisés
+void WebTerminal::CloseSubscribers() {
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    subscribersClosed = true;
+    for (Subscriber* subscriber : subscribers) {
+        if (!subscriber->closed) {
+            subscriber->closed = true;
+            subscriber->tsfn.Release();
+        }
+    }
+    subscriberCount = 0;
+
+    if (ring) {
+        ring->Close();
+        if (ring->TakeWaiter()) {
+            PostEvent(TerminalEvent::RingWake, 0);
+        }
+    }
+}
+
+void WebTerminal::UpdateReading() {
+    if (registration) {
+        io::Reactor::Instance().Refresh(registration);
+        if (childExited.load()) {
+            // Un PTY dont le processus est parti ne signale plus rien : ce
+            // qui reste est lu tout de suite
+            io::Reactor::Instance().ReadNow(registration);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(flowMutex);
+        flowCv.notify_all();
+    }
+}
+
+void WebTerminal::FlushPending() {
+    io::BufferPool& pool = io::BufferPool::Instance();
+    std::chrono::steady_clock::time_point readAt = pendingSince;
+
+    // Un caractère UTF-8 ou une séquence d'échappement coupé en fin de lot
+    // attend la lecture suivante, sauf si le bloc est déjà plein.
+    size_t held = framing ? vt::IncompleteTail(pending->data, pending->size) : 0;
+    if (activeTriggers && activeTriggers->HasStrip()) {
+        // De même pour le début d'une occurrence à retirer
+        held = std::max(held, std::min<size_t>(activeTriggers->Depth(triggerState), pending->size));
+    }
+    if (held == pending->size) {
+        if (pending->size < pending->capacity) {
+            return;
+        }
+        held = 0;
+    }
+    size_t ready = pending->size - held;
+    if (held > 0) {
+        pendingSince = std::chrono::steady_clock::now();
+    }
+
+    if (coalesceLatency.load().count() > 0 && ready <= pending->capacity / 4) {
+        // Petit lot (écho clavier) : on copie dans un bloc ajusté et on
+        // garde le grand bloc pour la suite plutôt que de l'immobiliser
+        // jusqu'au prochain GC.
+        io::Block* small = pool.Acquire(ready);
+        memcpy(small->data, pending->data, ready);
+        small->size = static_cast<uint32_t>(ready);
+        memmove(pending->data, pending->data + ready, held);
+        pending->size = static_cast<uint32_t>(held);
+        SendOutput(small, readAt);
+    } else {
+        io::Block* next = nullptr;
+        if (held > 0) {
+            next = pool.Acquire(std::max<size_t>(held + readSize, pending->capacity));
+            memcpy(next->data, pending->data + ready, held);
+            next->size = static_cast<uint32_t>(held);
+            pending->size = static_cast<uint32_t>(ready);
+        }
+        SendOutput(pending, readAt);
+        pending = next;
+    }
+    triggerScanned = held;
+}
+
+// Passe les octets arrivés depuis le dernier appel aux déclencheurs. Les
+// occurrences à retirer sont ôtées de pending avant tout envoi ; leur début
+// est encore là puisque FlushPending() retient les préfixes possibles.
+void WebTerminal::ScanTriggers() {
+    if (triggersVersion.load() != activeTriggersVersion) {
+        std::lock_guard<std::mutex> lock(triggersMutex);
+        activeTriggers = publishedTriggers;
+        activeTriggersVersion = triggersVersion.load();
+        triggerState = vt::TriggerSet::State();
+    }
+    if (!activeTriggers) {
+        triggerScanned = pending->size;
+        return;
+    }
+
+    triggerMatches.clear();
+    activeTriggers->Scan(pending->data + triggerScanned, pending->size - triggerScanned, &triggerState,
+                         &triggerMatches);
+    if (triggerMatches.empty()) {
+        triggerScanned = pending->size;
+        return;
+    }
+
+    // Tout ce qui précède pending est déjà dans l'historique
+    uint64_t base = scrollback.End();
+    size_t removed = 0;
+    for (const vt::TriggerSet::Match& match : triggerMatches) {
+        size_t end = triggerScanned + match.end - removed;
+        size_t start = end > match.length ? end - match.length : 0;
+        if (match.notify) {
+            uint64_t offset = match.strip || base + end < match.length ? base + start : base + end - match.length;
+            PostEvent(TerminalEvent::Trigger, offset, match.id);
+        }
+        if (match.strip) {
+            memmove(pending->data + start, pending->data + end, pending->size - end);
+            pending->size -= static_cast<uint32_t>(end - start);
+            removed += end - start;
+        }
+    }
+    triggerScanned = pending->size;
+}
+
+WebTerminal::ReadStatus WebTerminal::ReadChunk(bool wait, uint32_t* bytesRead) {
+    std::chrono::milliseconds latency = coalesceLatency.load();
+    size_t maxBatch = coalesceMaxBatch.load();
+    bool coalescing = latency.count() > 0;
+    *bytesRead = 0;
+
+    // Jamais de Read() bloquant avec un lot prêt en attente : rien de
+    // lisible, on l'envoie d'abord. La latence du lot reste ainsi bornée
+    // par le retour de la lecture, sans minuterie.
+    if (wait && pending && pending->size > 0 && pty->BytesAvailable() == 0) {
+        FlushPending();
+    }
+
+    if (!pending) {
+        pending = io::BufferPool::Instance().Acquire(
+            coalescing ? std::max<size_t>(readSize, maxBatch) : readSize);
+    }
+
+    // La lecture se fait directement dans le bloc qui partira vers JS
+    uint32_t request = std::min(readSize, pending->capacity - pending->size);
+    bool success = wait
+        ? pty->Read(pending->data + pending->size, request, bytesRead)
+        : pty->TryRead(pending->data + pending->size, request, bytesRead);
+    stats::Bump(counters.readCalls);
+
+    if (!success) {
+        unsigned long error = backend::LastError();
+        if (backend::IsNoDataError(error)) {
+            // Le tube est vide : ce qui a été accumulé part tout de suite
+            if (pending->size > 0) {
+                FlushPending();
+            }
+            return ReadStatus::Idle;
+        }
+        return backend::IsBrokenPipeError(error) ? ReadStatus::Closed : ReadStatus::Failed;
+    }
+
+    if (*bytesRead == 0) {
+        return ReadStatus::Data;
+    }
+    stats::Bump(counters.bytesRead, *bytesRead);
+
+    // La taille de lecture grandit tant que les lectures remplissent le tampon
+    // et redescend quand le flux redevient interactif.
+    bool drained = *bytesRead < request;
+    if (!drained && request == readSize && readSize < kMaxReadSize) {
+        readSize *= 2;
+        shortReads = 0;
+    } else if (*bytesRead < readSize / 4 && readSize > kMinReadSize && ++shortReads >= 8) {
+        readSize /= 2;
+        shortReads = 0;
+    }
+
+    if (pending->size == 0) {
+        pendingSince = std::chrono::steady_clock::now();
+    }
+    pending->size += *bytesRead;
+    ScanTriggers();
+
+    // Pas de minuterie : tant que des données arrivent on relit aussitôt,
+    // et dès que le tube est vide on envoie ce qui a été accumulé, que la
+    // lecture ait rempli la demande ou non. Sans attente (réacteur), c'est
+    // le TryRead() suivant qui constate le vide.
+    bool flush = !coalescing
+        || pending->size >= maxBatch
+        || pending->size == pending->capacity
+        || (wait && pty->BytesAvailable() == 0)
+        || std::chrono::steady_clock::now() - pendingSince >= latency;
+
+    if (flush) {
+        FlushPending();
+    }
+    return ReadStatus::Data;
+}
+
+void WebTerminal::FinishOutput() {
+    if (outputFinished) {
+        return;
+    }
+    outputFinished = true;
+    if (counters.processStarted.load(std::memory_order_relaxed) != 0
+        && counters.processEnded.load(std::memory_order_relaxed) == 0) {
+        counters.processEnded.store(stats::NowNs(), std::memory_order_relaxed);
+    }
+
+    if (pending && pending->size > 0) {
+        SendOutput(pending, pendingSince);
+    } else {
+        io::BufferPool::Instance().Release(pending);
+    }
+    pending = nullptr;
+    CloseSubscribers();
+
+    if (!hasCallback.load()) {
+        return;
+    }
+    try {
+        tsfn.Release();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error releasing tsfn: " << e.what());
+    }
+}
+
+void WebTerminal::ReadLoop() {
+    if (!pty) {
+        LOG_ERROR("ReadLoop: PTY is null");
+        return;
+    }
+
+    uint32_t bytesRead;
+    while (running.load()) {
+        if (!WantsRead()) {
+            // En pause ou file JS pleine : on attend sans toucher au PTY
+            std::unique_lock<std::mutex> lock(flowMutex);
+            flowCv.wait(lock, [this]() { return !running.load() || WantsRead(); });
+            continue;
+        }
+
+        ReadStatus status = ReadChunk(true, &bytesRead);
+        if (status == ReadStatus::Closed || status == ReadStatus::Failed) {
+            // Le processus a fermé le terminal, ou le PTY ne produira plus
+            // rien : comme avec le réacteur, la fin passe par l'observateur
+            // de sortie, sans réessayer en boucle
+            if (status == ReadStatus::Failed) {
+                LOG_ERROR("PTY read failed with error: " << backend::LastError());
+            }
+            break;
+        }
+        if (status != ReadStatus::Data && childExited.load()) {
+            // Processus terminé et PTY vidé
+            break;
+        }
+    }
+
+    FinishOutput();
+}
+
+void WebTerminal::OnReadable() {
+    // Quota par passage : un terminal très bavard ne doit pas monopoliser
+    // sa boucle, epoll (niveau) nous rappellera s'il reste des données.
+    size_t budget = 4 * kMaxReadSize;
+    uint32_t bytesRead;
+
+    while (running.load()) {
+        if (!WantsRead()) {
+            // Pause ou file JS pleine : le descripteur sort de la boucle
+            // jusqu'au prochain UpdateReading()
+            io::Reactor::Instance().Refresh(registration);
+            return;
+        }
+
+        switch (ReadChunk(false, &bytesRead)) {
+        case ReadStatus::Data:
+            if (bytesRead >= budget) {
+                return;
+            }
+            budget -= bytesRead;
+            break;
+        case ReadStatus::Idle:
+            if (childExited.load()) {
+                // Processus terminé et PTY vidé : plus rien ne viendra
+                readClosed = true;
+                io::Reactor::Instance().Refresh(registration);
+                FinishOutput();
+            }
+            return;
+        case ReadStatus::Closed:
+        case ReadStatus::Failed:
+            // Le descripteur ne produira plus rien : on le retire de la boucle
+            readClosed = true;
+            io::Reactor::Instance().Refresh(registration);
+            FinishOutput();
+            return;
+        }
+    }
+}
+
+void WebTerminal::StartIo()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    if (!ioStarted)
+    {
+        ioStarted = true;
+        if (io::Reactor::Available() && pty->PollFd() >= 0)
+        {
+            registration = io::Reactor::Instance().Register(pty->PollFd(), this);
+            if (!registration)
+            {
+                LOG_WARNING("Reactor registration failed, using I/O threads");
+            }
+        }
+        if (!registration)
+        {
+            writeThread = std::thread([this]()
+                                      { this->WriteLoop(); });
+        }
+    }
+
+    if (registration)
+    {
+        // onData() a pu arriver après le démarrage : WantsRead() a changé
+        io::Reactor::Instance().Refresh(registration);
+    }
+    else if (HasReaders() && !readThread.joinable())
+    {
+        readThread = std::thread([this]()
+                                 { this->ReadLoop(); });
+    }
+}
+
+// Création du PTY et exec hors du thread JS. Le terminal est retenu
+// (Ref) jusqu'au règlement de la promesse.
+class StartWorker : public Napi::AsyncWorker {
+public:
+    StartWorker(Napi::Env env, WebTerminal* terminal, int16_t cols, int16_t rows, backend::SpawnOptions options)
+        : Napi::AsyncWorker(env, "Terminal Start"),
+          deferred(Napi::Promise::Deferred::New(env)),
+          terminal(terminal),
+          options(std::move(options)),
+          cols(cols),
+          rows(rows) {
+    }
+
+    Napi::Promise Promise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (!terminal->SpawnProcess(cols, rows, options, &spawned, &error)) {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override {
+        terminal->OnProcessSpawned(Env(), deferred, std::move(spawned));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        terminal->running = false;
+        terminal->starting = false;
+        terminal->Unref();
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    WebTerminal* terminal;
+    backend::SpawnOptions options;
+    std::unique_ptr<backend::PtyBackend> spawned;
+    int16_t cols;
+    int16_t rows;
+};
+
+Napi::Value WebTerminal::StartProcess(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+    if (!pty)
+    {
+        throw Napi::Error::New(env, "PTY not initialized");
+    }
+    if (running.load() || starting)
+    {
+        throw Napi::Error::New(env, "Process already started");
+    }
+
+    int16_t width = 120, height = 30;
+    ReadyMode mode = ReadyMode::Exec;
+    std::string text;
+    Napi::Object pattern;
+    backend::SpawnOptions spawn;
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("cols"))
+        {
+            width = static_cast<int16_t>(options.Get("cols").As<Napi::Number>().Int32Value());
+        }
+        if (options.Has("rows"))
+        {
+            height = static_cast<int16_t>(options.Get("rows").As<Napi::Number>().Int32Value());
+        }
+        if (options.Has("ready"))
+        {
+            std::string ready = options.Get("ready").ToString().Utf8Value();
+            if (ready == "output")
+            {
+                mode = ReadyMode::Output;
+            }
+            else if (ready != "exec")
+            {
+                throw Napi::TypeError::New(env, "ready must be 'exec' or 'output'");
+            }
+        }
+        if (options.Has("prompt"))
+        {
+            Napi::Value prompt = options.Get("prompt");
+            if (prompt.IsString())
+            {
+                text = prompt.As<Napi::String>().Utf8Value();
+                if (text.empty())
+                {
+                    throw Napi::TypeError::New(env, "prompt must not be empty");
+                }
+            }
+            else if (prompt.IsObject() && prompt.As<Napi::Object>().Get("test").IsFunction())
+            {
+                pattern = prompt.As<Napi::Object>();
+            }
+            else
+            {
+                throw Napi::TypeError::New(env, "prompt must be a string or a RegExp");
+            }
+            mode = ReadyMode::Pattern;
+        }
+        if (options.Has("file"))
+        {
+            if (!options.Get("file").IsString())
+            {
+                throw Napi::TypeError::New(env, "file must be a string");
+            }
+            spawn.file = options.Get("file").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("args"))
+        {
+            if (!options.Get("args").IsArray())
+            {
+                throw Napi::TypeError::New(env, "args must be an array of strings");
+            }
+            Napi::Array args = options.Get("args").As<Napi::Array>();
+            spawn.args.reserve(args.Length());
+            for (uint32_t i = 0; i < args.Length(); i++)
+            {
+                spawn.args.push_back(args.Get(i).ToString().Utf8Value());
+            }
+        }
+        if (options.Has("env"))
+        {
+            if (!options.Get("env").IsObject())
+            {
+                throw Napi::TypeError::New(env, "env must be an object");
+            }
+            spawn.environment = BuildEnvironment(env, options.Get("env").As<Napi::Object>());
+        }
+        if (options.Has("cwd"))
+        {
+            if (!options.Get("cwd").IsString())
+            {
+                throw Napi::TypeError::New(env, "cwd must be a string");
+            }
+            spawn.cwd = options.Get("cwd").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("loopback"))
+        {
+            spawn.loopback = ParseLoopback(env, options.Get("loopback"));
+        }
+    }
+
+    LOG_DEBUG("Creating PTY with size: " << width << "x" << height);
+
+#ifdef _WIN32
+    // Configuration UTF-8
+    if (!SetConsoleOutputCP(CP_UTF8) || !SetConsoleCP(CP_UTF8))
+    {
+        LOG_WARNING("Failed to set console code page to UTF-8");
+    }
+#endif
+
+    if (emulator)
+    {
+        emulator->Resize(width, height);
+    }
+    if (recorder)
+    {
+        recorder->RecordResize(width, height);
+    }
+    {
+        std::lock_guard<std::mutex> lock(resizeMutex);
+        appliedCols = width;
+        appliedRows = height;
+    }
+
+    running = true;
+    starting = true;
+    readyMode = mode;
+    readyText = text;
+    readyBuffer.clear();
+    if (!pattern.IsEmpty())
+    {
+        readyPattern.Reset(pattern, 1);
+    }
+
+    Ref();
+    StartWorker* worker = new StartWorker(env, this, width, height, std::move(spawn));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+bool WebTerminal::SpawnProcess(int16_t cols, int16_t rows, const backend::SpawnOptions& options, std::unique_ptr<backend::PtyBackend>* spawned, std::string* error) {
+    // Thread du pool libuv : rien ici ne touche à JS ni à this->pty, le
+    // PTY lancé n'est installé que par OnProcessSpawned()
+    backend::SpawnOptions command = options;
+    if (command.file.empty()) {
+        command.file = backend::DefaultShell();
+    }
+
+    // Les shells du pool ont l'environnement et le répertoire de Node
+    std::unique_ptr<backend::PtyBackend> started;
+    if (command.loopback) {
+        command.file = "loopback";
+    } else if (command.IsDefault()) {
+        started = backend::PtyPool::Instance().Acquire(command.file, cols, rows);
+    }
+    if (started) {
+        LOG_DEBUG("Using pre-started shell from the pool, PID: " << started->GetProcessId());
+        counters.processStarted.store(stats::NowNs(), std::memory_order_relaxed);
+        *spawned = std::move(started);
+        return true;
+    }
+
+    started = command.loopback ? backend::CreateLoopback(*command.loopback) : backend::CreateDefault();
+    if (!started->Create(cols, rows)) {
+        unsigned long code = backend::LastError();
+        LOG_ERROR("PTY creation failed with error: " << code);
+        *error = "Failed to create pseudo console: " + std::to_string(code);
+        return false;
+    }
+
+    LOG_INFO("Starting process: " << command.file);
+
+    // Ne rend la main qu'une fois l'exec réussi ou échoué
+    if (!started->Start(command)) {
+        unsigned long code = backend::LastError();
+        LOG_ERROR("Failed to start shell with error: " << code);
+        *error = "Failed to start process: " + std::to_string(code);
+        return false;
+    }
+
+    if (started->GetProcessId() == 0) {
+        *error = "Process started but no PID obtained";
+        return false;
+    }
+    counters.processStarted.store(stats::NowNs(), std::memory_order_relaxed);
+    *spawned = std::move(started);
+    return true;
+}
+
+// PTY lancé par startProcess() ou repris par attach()
+void WebTerminal::InstallPty(std::unique_ptr<backend::PtyBackend> spawned) {
+    pty = std::move(spawned);
+    processId = pty->GetProcessId();
+    initialized = true;
+    StartIo();
+    if (!pty->WatchExit(this)) {
+        LOG_WARNING("Exit notification unavailable for PID " << processId);
+    }
+}
+
+void WebTerminal::OnProcessSpawned(Napi::Env env, Napi::Promise::Deferred deferred, std::unique_ptr<backend::PtyBackend> spawned) {
+    InstallPty(std::move(spawned));
+    LOG_INFO("Process started with PID: " << processId);
+
+    startDeferred.reset(new Napi::Promise::Deferred(deferred));
+    if (readyMode == ReadyMode::Exec) {
+        SettleStart(env, Napi::Value());
+    } else if (readyMode == ReadyMode::Pattern && frameEncoder) {
+        SettleStart(env, Napi::Error::New(env, "ready: prompt needs onData without encoding 'frame'").Value());
+    } else if (!hasCallback.load()) {
+        // Sans onData la sortie n'est jamais lue
+        SettleStart(env, Napi::Error::New(env, "ready: 'output' and prompt need an onData callback").Value());
+    }
+}
+
+// Appelé sur le thread JS pour chaque morceau livré tant que la promesse attend
+void WebTerminal::CheckReady(Napi::Env env, const char* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (readyMode != ReadyMode::Pattern) {
+        SettleStart(env, Napi::Value());
+        return;
+    }
+
+    // Le motif peut être coupé entre deux morceaux : on garde la fin de la sortie
+    readyBuffer.append(data, size);
+    if (readyBuffer.size() > kMaxReadyBuffer) {
+        readyBuffer.erase(0, readyBuffer.size() - kMaxReadyBuffer);
+    }
+
+    bool matched;
+    if (!readyText.empty()) {
+        matched = readyBuffer.find(readyText) != std::string::npos;
+    } else {
+        Napi::Object pattern = readyPattern.Value();
+        pattern.Set("lastIndex", Napi::Number::New(env, 0));
+        matched = pattern.Get("test").As<Napi::Function>()
+            .Call(pattern, {Napi::String::New(env, readyBuffer)}).ToBoolean();
+    }
+    if (matched) {
+        SettleStart(env, Napi::Value());
+    }
+}
+
+// error vide : résolution avec le PID
+void WebTerminal::SettleStart(Napi::Env env, Napi::Value error) {
+    std::unique_ptr<Napi::Promise::Deferred> deferred = std::move(startDeferred);
+    if (!deferred) {
+        return;
+    }
+    starting = false;
+    readyText.clear();
+    readyPattern.Reset();
+    readyBuffer.clear();
+
+    if (error.IsEmpty()) {
+        deferred->Resolve(Napi::Number::New(env, processId));
+    } else {
+        deferred->Reject(error);
+    }
+    Unref();
+}
+
+// Thread de surveillance : la fin est remontée à JS, et le PTY est vidé
+// tout de suite plutôt qu'à la prochaine lecture en échec
+void WebTerminal::OnProcessExit(int code, int signal) {
+    LOG_INFO("Process " << processId << " exited with code " << code << ", signal " << signal);
+    counters.processEnded.store(stats::NowNs(), std::memory_order_relaxed);
+    childExited = true;
+    PostEvent(TerminalEvent::Exit,
+              (static_cast<uint64_t>(static_cast<uint32_t>(signal)) << 32) | static_cast<uint32_t>(code));
+
+    if (registration) {
+        io::Reactor::Instance().ReadNow(registration);
+    } else {
+        // Le thread de lecture finit ce qui reste puis sort au premier vide
+        pty->CancelIo();
+        std::lock_guard<std::mutex> lock(flowMutex);
+        flowCv.notify_all();
+    }
+}
+
+// onExit() part une fois la fin connue et la sortie entièrement livrée
+void WebTerminal::MaybeFinishExit(Napi::Env env) {
+    if (!exitReported || exitFired || (hasCallback.load() && !outputDone)) {
+        return;
+    }
+    exitFired = true;
+
+    Teardown();
+    SettleStart(env, Napi::Error::New(env, "Process exited before it was ready").Value());
+    if (!exitCallback.IsEmpty()) {
+        exitCallback.Call({Napi::Number::New(env, exitCode), Napi::Number::New(env, exitSignal)});
+    }
+}
+
+// Réveille les Atomics.wait() posés sur la tête de l'anneau
+static void NotifyRing(Napi::Env env, Napi::Object words) {
+    Napi::Object atomics = env.Global().Get("Atomics").As<Napi::Object>();
+    atomics.Get("notify").As<Napi::Function>().Call(
+        atomics, {words, Napi::Number::New(env, io::SharedRing::Head)});
+}
+
+void EventChannel::Dispatch(Napi::Env env, Napi::Function, EventChannel* channel, TerminalEvent* event) {
+    std::unique_ptr<TerminalEvent> owned(event);
+    if (env == nullptr || !event || !channel->owner) return;
+
+    channel->owner->HandleEvent(env, *event);
+}
+
+void WebTerminal::PostEvent(TerminalEvent::Type type, uint64_t value, uint32_t trigger) {
+    TerminalEvent* event = new TerminalEvent{type, value, trigger};
+    if (events.NonBlockingCall(event) != napi_ok) {
+        delete event;
+    }
+}
+
+void WebTerminal::HandleEvent(Napi::Env env, const TerminalEvent& event) {
+    switch (event.type) {
+    case TerminalEvent::WriteProgress:
+        CompleteWrites(env.Null());
+        break;
+    case TerminalEvent::WriteError:
+        CompleteWrites(Napi::Error::New(env, "Write failed with error: " + std::to_string(event.value)).Value());
+        break;
+    case TerminalEvent::Drain:
+        if (!drainCallback.IsEmpty()) {
+            drainCallback.Call({});
+        }
+        break;
+    case TerminalEvent::Exit:
+        exitReported = true;
+        exitCode = static_cast<int32_t>(static_cast<uint32_t>(event.value));
+        exitSignal = static_cast<int32_t>(event.value >> 32);
+        MaybeFinishExit(env);
+        break;
+    case TerminalEvent::RingWake:
+        if (!ringWords.IsEmpty()) {
+            NotifyRing(env, ringWords.Value());
+        }
+        break;
+    case TerminalEvent::Trigger: {
+        // Un déclencheur retiré entre-temps ne rappelle plus
+        auto found = triggerCallbacks.find(event.trigger);
+        if (found == triggerCallbacks.end()) {
+            break;
+        }
+        Napi::Function callback = found->second.callback.Value();
+        if (found->second.once) {
+            DropTrigger(event.trigger);
+        }
+        callback.Call({Napi::Number::New(env, event.trigger), Napi::Number::New(env, static_cast<double>(event.value))});
+        break;
+    }
+    }
+}
+
+void WebTerminal::CompleteWrites(Napi::Value error) {
+    // Sur erreur la file a été vidée : tous les rappels échouent
+    uint64_t done = error.IsNull() ? bytesWritten.load() : UINT64_MAX;
+    while (!writeCallbacks.empty() && writeCallbacks.front().end <= done) {
+        Napi::FunctionReference callback = std::move(writeCallbacks.front().callback);
+        writeCallbacks.pop_front();
+        callback.Call({error});
+    }
+    SyncWriteCallbacks();
+}
+
+void WebTerminal::SyncWriteCallbacks() {
+    uint64_t next = writeCallbacks.empty() ? UINT64_MAX : writeCallbacks.front().end;
+    nextWriteCallback = next;
+
+    // L'écrivain a pu dépasser ce seuil avant de le voir
+    if (next != UINT64_MAX && bytesWritten.load() >= next) {
+        PostEvent(TerminalEvent::WriteProgress, bytesWritten.load());
+    }
+}
+
+void WebTerminal::NotifyInputProgress() {
+    // Appelé sous writeMutex
+    uint64_t written = writeQueue.TotalWritten();
+    bytesWritten = written;
+    inputPending = !writeQueue.Empty();
+
+    uint64_t next = nextWriteCallback.load();
+    if (written >= next && nextWriteCallback.compare_exchange_strong(next, UINT64_MAX)) {
+        PostEvent(TerminalEvent::WriteProgress, written);
+    }
+
+    if (drainWanted && writeQueue.Size() == 0) {
+        drainWanted = false;
+        PostEvent(TerminalEvent::Drain, 0);
+    }
+}
+
+void WebTerminal::FailInput(unsigned long error) {
+    // Appelé sous writeMutex
+    LOG_ERROR("Write failed with error: " << error);
+    writeQueue.Clear();
+    inputFailed = true;
+    drainWanted = false;
+    PostEvent(TerminalEvent::WriteError, error);
+}
+
+void WebTerminal::FlushInput() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    // Le PTY est non bloquant : on écrit ce qui passe, le reste attend EPOLLOUT
+    while (!writeQueue.Empty() && !inputFailed.load()) {
+        size_t length;
+        const char* data = writeQueue.Front(&length);
+        uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(length, 1u << 30));
+        uint32_t written = 0;
+
+        stats::Bump(counters.writeCalls);
+        if (!pty->TryWrite(data, chunk, &written)) {
+            unsigned long error = backend::LastError();
+            if (backend::IsNoDataError(error)) {
+                stats::Bump(counters.writeStalls);
+            } else {
+                FailInput(error);
+            }
+            break;
+        }
+
+        stats::Bump(counters.bytesWritten, written);
+        if (recorder && written > 0) {
+            // Enregistré dans l'ordre où les octets atteignent le PTY
+            recorder->RecordInput(data, written);
+        }
+        writeQueue.Consume(written);
+        if (written < chunk) {
+            // Tampon noyau plein : la suite attend EPOLLOUT
+            stats::Bump(counters.writeStalls);
+            break;
+        }
+    }
+
+    NotifyInputProgress();
+}
+
+void WebTerminal::OnWritable() {
+    FlushInput();
+    io::Reactor::Instance().Refresh(registration);
+}
+
+bool WebTerminal::WantsWrite() {
+    return inputPending.load() && !inputFailed.load();
+}
+
+void WebTerminal::WriteLoop() {
+    // Backends sans réacteur : les écritures bloquantes se font ici, hors du thread JS
+    std::unique_lock<std::mutex> lock(writeMutex);
+    while (running.load()) {
+        std::string segment;
+        if (!writeQueue.TakeFront(&segment)) {
+            // Des collages abandonnés ont pu compléter des écritures
+            NotifyInputProgress();
+            writeCv.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        uint32_t written = 0;
+        bool success = pty->Write(segment.data(), static_cast<uint32_t>(segment.size()), &written);
+        unsigned long error = success ? 0 : backend::LastError();
+        stats::Bump(counters.writeCalls);
+        stats::Bump(counters.bytesWritten, written);
+        if (recorder && written > 0) {
+            recorder->RecordInput(segment.data(), written);
+        }
+        lock.lock();
+
+        writeQueue.Acknowledge(written);
+        if (!success && running.load()) {
+            FailInput(error);
+        }
+        NotifyInputProgress();
+    }
+}
+
+// Les Buffer/Uint8Array sont pris tels quels, sans passer par une chaîne
+static bool GetInputBytes(Napi::Value value, std::string* text, const char** data, size_t* length) {
+    if (value.IsString()) {
+        *text = value.As<Napi::String>().Utf8Value();
+        *data = text->data();
+        *length = text->size();
+        return true;
+    }
+    if (value.IsTypedArray()) {
+        Napi::TypedArray array = value.As<Napi::TypedArray>();
+        *data = static_cast<const char*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+        *length = array.ByteLength();
+        return true;
+    }
+    return false;
+}
+
+// Frappes qui doivent passer devant un collage en cours : signaux (Ctrl-C,
+// Ctrl-\, Ctrl-Z) et contrôle de flux (Ctrl-Q, Ctrl-S)
+static bool IsUrgentInput(const char* data, size_t length) {
+    if (length == 0 || length > 4) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        switch (data[i]) {
+        case 0x03: case 0x1c: case 0x1a: case 0x11: case 0x13:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+void WebTerminal::AddWriteCallback(uint64_t end, Napi::Function callback) {
+    // Une écriture urgente peut finir avant celles déjà en file
+    auto position = std::upper_bound(writeCallbacks.begin(), writeCallbacks.end(), end,
+                                     [](uint64_t value, const PendingWrite& pending) { return value < pending.end; });
+    writeCallbacks.insert(position, PendingWrite{end, Napi::Persistent(callback)});
+}
+
+void WebTerminal::KickInput() {
+    if (registration) {
+        // Frappe clavier : écrite tout de suite, sans attendre le réacteur
+        FlushInput();
+        if (inputPending.load()) {
+            io::Reactor::Instance().Refresh(registration);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        writeCv.notify_one();
+    }
+}
+
+Napi::Value WebTerminal::Write(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+    if (!pty)
+    {
+        throw Napi::Error::New(env, "PTY not initialized");
+    }
+
+    std::string text;
+    const char* data = nullptr;
+    size_t length = 0;
+    if (info.Length() < 1 || !GetInputBytes(info[0], &text, &data, &length))
+    {
+        throw Napi::TypeError::New(env, "String, Buffer or Uint8Array expected");
+    }
+
+    if (!initialized)
+    {
+        throw Napi::Error::New(env, "Process not started");
+    }
+    if (inputFailed.load())
+    {
+        throw Napi::Error::New(env, "PTY input closed");
+    }
+
+    bool urgent = IsUrgentInput(data, length);
+    uint64_t end;
+    bool belowHighWater;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (urgent)
+        {
+            uint64_t position = writeQueue.PushUrgent(data, length);
+            end = position + length;
+            // Ce qui attendait derrière sera écrit length octets plus tard
+            for (PendingWrite& pending : writeCallbacks)
+            {
+                if (pending.end > position)
+                {
+                    pending.end += length;
+                }
+            }
+            if (memchr(data, 0x03, length) || memchr(data, 0x1c, length))
+            {
+                // Interruption : le reste des collages n'est pas envoyé
+                size_t dropped = writeQueue.DropPastes();
+                if (dropped > 0)
+                {
+                    LOG_DEBUG("Interrupt dropped " << dropped << " pasted bytes");
+                }
+            }
+        }
+        else
+        {
+            writeQueue.Push(data, length);
+            end = writeQueue.TotalPushed();
+        }
+        inputPending = true;
+        belowHighWater = writeQueue.Size() < kInputHighWater;
+        if (!belowHighWater)
+        {
+            drainWanted = true;
+        }
+    }
+
+    if (info.Length() > 1 && info[1].IsFunction())
+    {
+        AddWriteCallback(end, info[1].As<Napi::Function>());
+        SyncWriteCallbacks();
+    }
+    else if (urgent)
+    {
+        // Les seuils des rappels en attente ont été décalés
+        SyncWriteCallbacks();
+    }
+
+    KickInput();
+    return Napi::Boolean::New(env, belowHighWater);
+}
+
+Napi::Value WebTerminal::Paste(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+    if (!pty)
+    {
+        throw Napi::Error::New(env, "PTY not initialized");
+    }
+
+    std::string text;
+    const char* data = nullptr;
+    size_t length = 0;
+    if (info.Length() < 1 || !GetInputBytes(info[0], &text, &data, &length))
+    {
+        throw Napi::TypeError::New(env, "String, Buffer or Uint8Array expected");
+    }
+
+    if (!initialized)
+    {
+        throw Napi::Error::New(env, "Process not started");
+    }
+    if (inputFailed.load())
+    {
+        throw Napi::Error::New(env, "PTY input closed");
+    }
+
+    // Par défaut, suit le mode 2004 de l'application (modèle d'écran requis)
+    bool bracketed = emulator && emulator->BracketedPaste();
+    Napi::Function callback;
+    for (size_t i = 1; i < info.Length() && i < 3; i++)
+    {
+        if (info[i].IsFunction())
+        {
+            callback = info[i].As<Napi::Function>();
+        }
+        else if (info[i].IsObject() && info[i].As<Napi::Object>().Has("bracketed"))
+        {
+            bracketed = info[i].As<Napi::Object>().Get("bracketed").ToBoolean();
+        }
+    }
+
+    std::string body;
+    if (bracketed)
+    {
+        // Un marqueur de fin dans le texte collé sortirait l'application du mode collage
+        body.assign(data, length);
+        size_t found;
+        while ((found = body.find(kPasteEnd)) != std::string::npos)
+        {
+            body.erase(found, sizeof(kPasteEnd) - 1);
+        }
+        data = body.data();
+        length = body.size();
+    }
+
+    uint64_t end;
+    bool belowHighWater;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (bracketed)
+        {
+            writeQueue.Push(kPasteStart, sizeof(kPasteStart) - 1);
+        }
+        writeQueue.PushPaste(data, length);
+        if (bracketed)
+        {
+            // Segment ordinaire : envoyé même si le collage est interrompu
+            writeQueue.Push(kPasteEnd, sizeof(kPasteEnd) - 1);
+        }
+        end = writeQueue.TotalPushed();
+        inputPending = true;
+        belowHighWater = writeQueue.Size() < kInputHighWater;
+        if (!belowHighWater)
+        {
+            drainWanted = true;
+        }
+    }
+
+    if (!callback.IsEmpty())
+    {
+        AddWriteCallback(end, callback);
+        SyncWriteCallbacks();
+    }
+
+    KickInput();
+    return Napi::Boolean::New(env, belowHighWater);
+}
+
+Napi::Value WebTerminal::OnDrain(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "Function expected");
+    }
+
+    drainCallback = Napi::Persistent(info[0].As<Napi::Function>());
+    return env.Undefined();
+}
+
+Napi::Value WebTerminal::OnExit(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "Function expected");
+    }
+
+    exitCallback = Napi::Persistent(info[0].As<Napi::Function>());
+    if (exitFired)
+    {
+        // Le processus est déjà terminé
+        exitCallback.Call({Napi::Number::New(env, exitCode), Napi::Number::New(env, exitSignal)});
+    }
+    return env.Undefined();
+}
+
+Napi::Value WebTerminal::OnData(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "Function expected");
+    }
+
+    if (hasCallback)
+    {
+        throw Napi::Error::New(env, "Data callback already set");
+    }
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+
+    bool utf8 = false;
+    bool frame = false;
+    uint32_t sessionId = 0;
+    int32_t level = 0;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("maxLatency"))
+        {
+            int32_t latency = options.Get("maxLatency").As<Napi::Number>().Int32Value();
+            coalesceLatency = std::chrono::milliseconds(latency > 0 ? latency : 0);
+        }
+        if (options.Has("maxBatchSize"))
+        {
+            int32_t batch = options.Get("maxBatchSize").As<Napi::Number>().Int32Value();
+            if (batch <= 0)
+            {
+                throw Napi::RangeError::New(env, "maxBatchSize must be positive");
+            }
+            coalesceMaxBatch = static_cast<size_t>(batch);
+        }
+        if (options.Has("maxQueuedBytes"))
+        {
+            double budget = options.Get("maxQueuedBytes").As<Napi::Number>().DoubleValue();
+            if (budget < 1)
+            {
+                throw Napi::RangeError::New(env, "maxQueuedBytes must be positive");
+            }
+            maxQueuedBytes = static_cast<size_t>(budget);
+        }
+        if (options.Has("encoding"))
+        {
+            std::string encoding = options.Get("encoding").ToString().Utf8Value();
+            if (encoding != "buffer" && encoding != "utf8" && encoding != "frame")
+            {
+                throw Napi::TypeError::New(env, "encoding must be 'buffer', 'utf8' or 'frame'");
+            }
+            utf8 = encoding == "utf8";
+            frame = encoding == "frame";
+        }
+        if (options.Has("sessionId"))
+        {
+            sessionId = options.Get("sessionId").As<Napi::Number>().Uint32Value();
+        }
+        if (options.Has("compress"))
+        {
+            Napi::Value compress = options.Get("compress");
+            level = compress.IsNumber() ? compress.As<Napi::Number>().Int32Value() : (compress.ToBoolean() ? 6 : 0);
+            if (level < 0 || level > 9)
+            {
+                throw Napi::RangeError::New(env, "compress must be a boolean or a level from 0 to 9");
+            }
+        }
+        if (options.Has("framing"))
+        {
+            framing = options.Get("framing").ToBoolean().Value();
+        }
+    }
+    // Les chaînes exigent des morceaux coupés entre deux caractères
+    if (utf8)
+    {
+        framing = true;
+    }
+
+    if (frame)
+    {
+        if (startDeferred && readyMode == ReadyMode::Pattern)
+        {
+            throw Napi::Error::New(env, "encoding 'frame' cannot wait for a ready prompt");
+        }
+        frameEncoder.reset(new io::FrameEncoder(sessionId, level));
+        if (!frameEncoder->Init())
+        {
+            frameEncoder.reset();
+            throw Napi::Error::New(env, "Failed to initialize output compression");
+        }
+    }
+
+    LOG_DEBUG("Setting up data callback");
+    channel = new OutputChannel();
+    channel->owner = this;
+    channel->utf8 = utf8;
+    tsfn = OutputFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "Terminal Callback",
+        0,
+        1,
+        channel,
+        [](Napi::Env env, OutputChannel* channel) {
+            if (channel->owner)
+            {
+                WebTerminal* owner = channel->owner;
+                owner->channel = nullptr;
+                owner->outputDone = true;
+                if (owner->startDeferred)
+                {
+                    // Toute la sortie a été livrée sans que le terminal soit prêt
+                    owner->SettleStart(env, Napi::Error::New(env, "Process exited before it was ready").Value());
+                }
+                owner->MaybeFinishExit(env);
+            }
+            delete channel;
+        });
+    hasCallback = true;
+
+    StartIo();
+
+    return env.Undefined();
+}
+
+void Subscriber::Deliver(Napi::Env env, Napi::Function callback, Subscriber* subscriber, io::Block* block) {
+    if (!block) return;
+
+    size_t remaining = subscriber->queuedBytes -= block->size;
+    if (env == nullptr || callback.IsEmpty()) {
+        io::BufferPool::Instance().Release(block);
+        return;
+    }
+
+    double offset = static_cast<double>(block->offset);
+    callback.Call({LendBlock(env, block), Napi::Number::New(env, offset)});
+
+    if (subscriber->lagging.load() && subscriber->owner && remaining < subscriber->maxQueuedBytes / 2) {
+        subscriber->owner->CatchUp(subscriber);
+    }
+}
+
+Napi::Value WebTerminal::Subscribe(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "Function expected");
+    }
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+
+    size_t budget = 4 * 1024 * 1024;
+    bool replay = false;
+    uint64_t from = 0;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("maxQueuedBytes"))
+        {
+            double bytes = options.Get("maxQueuedBytes").As<Napi::Number>().DoubleValue();
+            if (bytes < 1)
+            {
+                throw Napi::RangeError::New(env, "maxQueuedBytes must be positive");
+            }
+            budget = static_cast<size_t>(bytes);
+        }
+        if (options.Has("from"))
+        {
+            double offset = options.Get("from").As<Napi::Number>().DoubleValue();
+            if (offset < 0)
+            {
+                throw Napi::RangeError::New(env, "from must not be negative");
+            }
+            replay = true;
+            from = static_cast<uint64_t>(offset);
+        }
+    }
+
+    Subscriber* subscriber = new Subscriber();
+    subscriber->owner = this;
+    subscriber->id = ++nextSubscriberId;
+    subscriber->maxQueuedBytes = budget;
+    subscriber->queuedBytes = 0;
+    subscriber->lagging = false;
+    subscriber->cursor = 0;
+    subscriber->closed = false;
+    subscriber->tsfn = Napi::TypedThreadSafeFunction<Subscriber, io::Block, &Subscriber::Deliver>::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "Terminal Subscriber",
+        0,
+        1,
+        subscriber,
+        [](Napi::Env, Subscriber* subscriber) {
+            if (subscriber->owner)
+            {
+                WebTerminal* owner = subscriber->owner;
+                std::lock_guard<std::mutex> lock(owner->subscribersMutex);
+                owner->subscribers.erase(
+                    std::find(owner->subscribers.begin(), owner->subscribers.end(), subscriber));
+            }
+            delete subscriber;
+        });
+
+    {
+        // Position prise sous le verrou de FanOut() : rien ne se perd entre
+        // l'historique rejoué et le direct
+        std::lock_guard<std::mutex> lock(subscribersMutex);
+        subscribers.push_back(subscriber);
+        subscriber->cursor = replay ? from : scrollback.End();
+        if (subscriber->cursor < scrollback.End())
+        {
+            subscriber->lagging = true;
+            CatchUpLocked(subscriber);
+        }
+        if (subscribersClosed)
+        {
+            // Sortie déjà terminée : seulement l'historique
+            subscriber->closed = true;
+            subscriber->tsfn.Release();
+        }
+        else
+        {
+            subscriberCount++;
+        }
+    }
+
+    StartIo();
+    return Napi::Number::New(env, subscriber->id);
+}
+
+Napi::Value WebTerminal::Unsubscribe(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "Subscription id expected");
+    }
+    uint32_t id = info[0].As<Napi::Number>().Uint32Value();
+
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    for (Subscriber* subscriber : subscribers)
+    {
+        if (subscriber->id == id && !subscriber->closed)
+        {
+            // Retiré de la liste par le finaliseur, une fois la file vidée
+            subscriber->closed = true;
+            subscriber->tsfn.Release();
+            subscriberCount--;
+            return Napi::Boolean::New(env, true);
+        }
+    }
+    return Napi::Boolean::New(env, false);
+}
+
+Napi::Value WebTerminal::SetOutputRing(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (tornDown && detached)
+    {
+        throw Napi::Error::New(env, "Terminal detached");
+    }
+    if (info.Length() < 1 || !(info[0].IsTypedArray() || info[0].IsNull() || info[0].IsUndefined()))
+    {
+        throw Napi::TypeError::New(env, "TypedArray over a SharedArrayBuffer expected");
+    }
+
+    std::unique_ptr<io::SharedRing> next;
+    Napi::TypedArray view;
+    Napi::Object words;
+    if (info[0].IsTypedArray())
+    {
+        view = info[0].As<Napi::TypedArray>();
+        Napi::Value buffer = view.Get("buffer");
+        Napi::Function shared = env.Global().Get("SharedArrayBuffer").As<Napi::Function>();
+        if (!buffer.IsObject() || !buffer.As<Napi::Object>().InstanceOf(shared))
+        {
+            throw Napi::TypeError::New(env, "TypedArray over a SharedArrayBuffer expected");
+        }
+
+        napi_typedarray_type type;
+        size_t length;
+        void* data = nullptr;
+        napi_value arrayBuffer;
+        size_t byteOffset;
+        if (napi_get_typedarray_info(env, view, &type, &length, &data, &arrayBuffer, &byteOffset) != napi_ok)
+        {
+            throw Napi::Error::New(env, "Failed to access the ring buffer");
+        }
+        if (reinterpret_cast<uintptr_t>(data) % sizeof(uint32_t) != 0)
+        {
+            throw Napi::RangeError::New(env, "Ring buffer must be 4-byte aligned");
+        }
+        if (!io::SharedRing::IsValidLength(view.ByteLength()))
+        {
+            throw Napi::RangeError::New(env, "Ring buffer must be a 64-byte header plus a power of two of at least 4096 bytes");
+        }
+
+        words = env.Global().Get("Int32Array").As<Napi::Function>().New(
+            {buffer, Napi::Number::New(env, static_cast<double>(byteOffset)),
+             Napi::Number::New(env, static_cast<double>(io::SharedRing::kHeaderBytes / sizeof(uint32_t)))});
+        next.reset(new io::SharedRing(static_cast<char*>(data), view.ByteLength()));
+    }
+
+    std::unique_ptr<io::SharedRing> previous;
+    {
+        std::lock_guard<std::mutex> lock(subscribersMutex);
+        previous = std::move(ring);
+        ring = std::move(next);
+        if (ring && subscribersClosed)
+        {
+            // Sortie déjà terminée
+            ring->Close();
+        }
+        hasRing = ring != nullptr;
+    }
+    if (previous)
+    {
+        // Le consommateur de l'ancien anneau ne doit pas attendre pour rien
+        previous->Close();
+        NotifyRing(env, ringWords.Value());
+    }
+    // L'ancien SharedArrayBuffer n'est relâché qu'une fois hors de FanOut()
+    if (words.IsEmpty())
+    {
+        ringWords.Reset();
+        ringView.Reset();
+    }
+    else
+    {
+        ringWords.Reset(words, 1);
+        ringView.Reset(view, 1);
+    }
+
+    StartIo();
+    return env.Undefined();
+}
+
+Napi::Value WebTerminal::AddTrigger(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    std::string text;
+    const char* data = nullptr;
+    size_t length = 0;
+    if (info.Length() < 1 || !GetInputBytes(info[0], &text, &data, &length))
+    {
+        throw Napi::TypeError::New(env, "String, Buffer or Uint8Array expected");
+    }
+    if (length == 0 || length > kMaxTriggerLength)
+    {
+        throw Napi::RangeError::New(env, "Trigger pattern must be 1 to " + std::to_string(kMaxTriggerLength) + " bytes");
+    }
+    size_t total = length;
+    for (const vt::TriggerSet::Pattern& pattern : triggerPatterns)
+    {
+        total += pattern.text.size();
+    }
+    if (total > kMaxTriggerBytes)
+    {
+        throw Napi::RangeError::New(env, "Too many trigger patterns");
+    }
+
+    vt::TriggerSet::Pattern pattern{0, std::string(data, length), false, false, false};
+    bool once = false;
+    Napi::Function callback;
+    for (size_t i = 1; i < info.Length() && i < 3; i++)
+    {
+        if (info[i].IsFunction())
+        {
+            callback = info[i].As<Napi::Function>();
+        }
+        else if (info[i].IsObject())
+        {
+            Napi::Object options = info[i].As<Napi::Object>();
+            pattern.strip = options.Has("strip") && options.Get("strip").ToBoolean();
+            pattern.ignoreCase = options.Has("ignoreCase") && options.Get("ignoreCase").ToBoolean();
+            once = options.Has("once") && options.Get("once").ToBoolean();
+        }
+    }
+    if (callback.IsEmpty() && !pattern.strip)
+    {
+        throw Napi::TypeError::New(env, "Callback expected unless strip is set");
+    }
+
+    pattern.id = ++nextTriggerId;
+    pattern.notify = !callback.IsEmpty();
+    triggerPatterns.push_back(pattern);
+    if (pattern.notify)
+    {
+        triggerCallbacks.emplace(pattern.id, TriggerCallback{Napi::Persistent(callback), once});
+    }
+    PublishTriggers();
+    return Napi::Number::New(env, pattern.id);
+}
+
+Napi::Value WebTerminal::RemoveTrigger(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "Trigger id expected");
+    }
+    return Napi::Boolean::New(env, DropTrigger(info[0].As<Napi::Number>().Uint32Value()));
+}
+
+bool WebTerminal::DropTrigger(uint32_t id) {
+    auto found = std::find_if(triggerPatterns.begin(), triggerPatterns.end(),
+                              [id](const vt::TriggerSet::Pattern& pattern) { return pattern.id == id; });
+    if (found == triggerPatterns.end()) {
+        return false;
+    }
+    triggerPatterns.erase(found);
+    triggerCallbacks.erase(id);
+    PublishTriggers();
+    return true;
+}
+
+// Compile hors verrou ; la lecture prend le nouvel automate au passage suivant
+void WebTerminal::PublishTriggers() {
+    std::shared_ptr<const vt::TriggerSet> compiled;
+    if (!triggerPatterns.empty()) {
+        compiled = std::make_shared<const vt::TriggerSet>(triggerPatterns);
+    }
+    std::lock_guard<std::mutex> lock(triggersMutex);
+    publishedTriggers = std::move(compiled);
+    triggersVersion++;
+}
+
+Napi::Value WebTerminal::Pause(const Napi::CallbackInfo &info)
 {
-    std::cout << "Terminal constructor called" << std::endl;
-    pty = std::make_unique<conpty::ConPTY>();
+    paused = true;
+    UpdateReading();
+    return info.Env().Undefined();
 }
 
-WebTerminal::~WebTerminal()
+Napi::Value WebTerminal::Resume(const Napi::CallbackInfo &info)
 {
-    std::cout << "Terminal destructor called" << std::endl;
-    running = false;
-    if (readThread.joinable())
+    paused = false;
+    UpdateReading();
+    return info.Env().Undefined();
+}
+
+Napi::Value WebTerminal::GetQueuedBytes(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), static_cast<double>(queuedBytes.load()));
+}
+
+Napi::Value WebTerminal::GetScrollback(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    double fromOffset = 0;
+    if (info.Length() > 0 && info[0].IsNumber())
     {
-        readThread.join();
+        fromOffset = info[0].As<Napi::Number>().DoubleValue();
+        if (fromOffset < 0)
+        {
+            throw Napi::RangeError::New(env, "fromOffset must not be negative");
+        }
     }
-    if (pty)
+
+    size_t available = scrollback.Available(static_cast<uint64_t>(fromOffset));
+    size_t maxBytes = available;
+    if (info.Length() > 1 && info[1].IsNumber())
     {
-        pty->Close();
+        double limit = info[1].As<Napi::Number>().DoubleValue();
+        if (limit < 0)
+        {
+            throw Napi::RangeError::New(env, "maxBytes must not be negative");
+        }
+        maxBytes = std::min(available, static_cast<size_t>(limit));
     }
+
+    // Une seule copie, de l'anneau vers le Buffer rendu à JS
+    Napi::Buffer<char> data = Napi::Buffer<char>::New(env, maxBytes);
+    uint64_t start;
+    size_t length = scrollback.Read(static_cast<uint64_t>(fromOffset), data.Data(), maxBytes, &start);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("data", length == maxBytes ? data : Napi::Buffer<char>::Copy(env, data.Data(), length));
+    result.Set("offset", Napi::Number::New(env, static_cast<double>(start)));
+    result.Set("end", Napi::Number::New(env, static_cast<double>(start + length)));
+    return result;
 }
 
-Napi::Object WebTerminal::Init(Napi::Env env, Napi::Object exports)
+Napi::Value WebTerminal::ExportSnapshot(const Napi::CallbackInfo &info)
 {
-    Napi::Function func = DefineClass(env, "WebTerminal", {InstanceMethod("startProcess", &WebTerminal::StartProcess), InstanceMethod("write", &WebTerminal::Write), InstanceMethod("onData", &WebTerminal::OnData), InstanceMethod("resize", &WebTerminal::Resize), InstanceMethod("echo", &WebTerminal::Echo)});
+    Napi::Env env = info.Env();
 
-    Napi::FunctionReference *constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(func);
-    env.SetInstanceData(constructor);
+    if (!emulator)
+    {
+        throw Napi::Error::New(env, "Screen model disabled, create the terminal with { screen: true }");
+    }
 
-    exports.Set("WebTerminal", func);
-    return exports;
+    // 'ansi' : séquences qui redessinent l'écran chez un client xterm
+    if (info.Length() > 0 && info[0].IsString() && info[0].As<Napi::String>().Utf8Value() == "ansi")
+    {
+        return Napi::String::New(env, emulator->ExportAnsi());
+    }
+
+    std::string snapshot = emulator->Export();
+    return Napi::Buffer<char>::Copy(env, snapshot.data(), snapshot.size());
 }
 
-void WebTerminal::ReadLoop() {
-    if (!pty) {
-        std::cerr << "ReadLoop: PTY is null" << std::endl;
+void FrameChannel::Deliver(Napi::Env env, Napi::Function callback, FrameChannel* channel, std::string* frame) {
+    if (!frame) return;
+
+    if (channel->owner) {
+        channel->owner->framesInFlight--;
+    }
+
+    if (env == nullptr || callback.IsEmpty()) {
+        delete frame;
         return;
     }
 
-    const DWORD bufSize = 1024;
-    std::vector<char> buffer(bufSize);
-    DWORD bytesRead;
+    auto buf = Napi::Buffer<char>::NewOrCopy(
+        env, &(*frame)[0], frame->size(),
+        [](Napi::Env, char*, std::string* frame) { delete frame; },
+        frame);
+    callback.Call({buf});
+}
 
-    while (running.load()) {
-        if (pty->Read(buffer.data(), bufSize - 1, &bytesRead)) {
-            if (bytesRead > 0) {
-                auto callback = [](Napi::Env env, Napi::Function jsCallback, std::vector<char>* data) {
-                    if (!data) return;
-                    auto buf = Napi::Buffer<char>::Copy(env, data->data(), data->size());
-                    jsCallback.Call({buf});
-                    delete data;
-                };
-
-                std::vector<char>* dataToSend = new std::vector<char>(buffer.begin(), buffer.begin() + bytesRead);
-                tsfn.NonBlockingCall(dataToSend, callback);
-            }
-        } else {
-            DWORD error = GetLastError();
-            if (error != ERROR_NO_DATA && error != ERROR_BROKEN_PIPE) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
-        }
+void WebTerminal::OnTick() {
+    // Le client n'a pas encore consommé les trames précédentes : on attend,
+    // les lignes modifiées d'ici là partiront ensemble.
+    if (framesInFlight.load() >= kMaxFramesInFlight) {
+        return;
     }
 
-    try {
-        tsfn.Release();
-    } catch (const std::exception& e) {
-        std::cerr << "Error releasing tsfn: " << e.what() << std::endl;
+    std::string* frame = new std::string();
+    if (!emulator->TakeFrame(frame)) {
+        delete frame;
+        return;
+    }
+
+    framesInFlight++;
+    if (frames.NonBlockingCall(frame) != napi_ok) {
+        framesInFlight--;
+        delete frame;
     }
 }
 
-Napi::Value WebTerminal::StartProcess(const Napi::CallbackInfo &info)
+Napi::Value WebTerminal::OnFrame(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (!pty)
+    if (info.Length() < 1 || !info[0].IsFunction())
     {
-        throw Napi::Error::New(env, "PTY not initialized");
+        throw Napi::TypeError::New(env, "Function expected");
     }
-
-    try
+    if (!emulator)
     {
-        running = true;
-        std::cout << "Setting running to true" << std::endl;
+        throw Napi::Error::New(env, "Screen model disabled, create the terminal with { screen: true }");
+    }
+    if (hasFrameCallback)
+    {
+        throw Napi::Error::New(env, "Frame callback already set");
+    }
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
 
-        SHORT width = 120, height = 30;
-        if (info.Length() > 0 && info[0].IsObject())
+    int32_t fps = 30;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("fps"))
         {
-            Napi::Object options = info[0].As<Napi::Object>();
-            if (options.Has("cols"))
+            fps = options.Get("fps").As<Napi::Number>().Int32Value();
+            if (fps < 1 || fps > 240)
             {
-                width = static_cast<SHORT>(options.Get("cols").As<Napi::Number>().Int32Value());
+                throw Napi::RangeError::New(env, "fps must be between 1 and 240");
             }
-            if (options.Has("rows"))
+        }
+    }
+
+    frameChannel = new FrameChannel();
+    frameChannel->owner = this;
+    frames = FrameFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "Terminal Frames",
+        0,
+        1,
+        frameChannel,
+        [](Napi::Env, FrameChannel* channel) {
+            if (channel->owner)
             {
-                height = static_cast<SHORT>(options.Get("rows").As<Napi::Number>().Int32Value());
+                channel->owner->frameChannel = nullptr;
             }
-        }
+            delete channel;
+        });
+    // Les trames ne doivent pas retenir le processus Node à elles seules
+    frames.Unref(env);
+    hasFrameCallback = true;
 
-        std::cout << "Creating PTY with size: " << width << "x" << height << std::endl;
+    // La première trame contient tout l'écran
+    emulator->RequestFullFrame();
+    io::Ticker::Instance().Add(this, std::chrono::milliseconds(1000 / fps));
 
-        // Configuration UTF-8
-        if (!SetConsoleOutputCP(CP_UTF8) || !SetConsoleCP(CP_UTF8))
-        {
-            std::cerr << "Failed to set console code page to UTF-8" << std::endl;
-        }
+    return env.Undefined();
+}
 
-        if (!pty->Create(width, height))
-        {
-            running = false;
-            DWORD error = GetLastError();
-            std::cout << "ConPTY creation failed with error: " << error << std::endl;
-            throw Napi::Error::New(env, "Failed to create pseudo console: " + std::to_string(error));
-        }
+Napi::Value WebTerminal::ImportSnapshot(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (!emulator)
+    {
+        throw Napi::Error::New(env, "Screen model disabled, create the terminal with { screen: true }");
+    }
+    if (info.Length() < 1 || !info[0].IsBuffer())
+    {
+        throw Napi::TypeError::New(env, "Buffer expected");
+    }
+
+    Napi::Buffer<char> snapshot = info[0].As<Napi::Buffer<char>>();
+    if (!emulator->Import(snapshot.Data(), snapshot.Length()))
+    {
+        throw Napi::Error::New(env, "Invalid screen snapshot");
+    }
+    return env.Undefined();
+}
+
+// Compteurs en objet JS ; l'histogramme est cumulatif (seaux "le" à la
+// Prometheus), le dernier seau étant illimité.
+static Napi::Object StatsToObject(Napi::Env env, const stats::Snapshot& snapshot)
+{
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("bytesRead", Napi::Number::New(env, static_cast<double>(snapshot.bytesRead)));
+    result.Set("readCalls", Napi::Number::New(env, static_cast<double>(snapshot.readCalls)));
+    result.Set("bytesWritten", Napi::Number::New(env, static_cast<double>(snapshot.bytesWritten)));
+    result.Set("writeCalls", Napi::Number::New(env, static_cast<double>(snapshot.writeCalls)));
+    result.Set("writeStalls", Napi::Number::New(env, static_cast<double>(snapshot.writeStalls)));
+    result.Set("callbacks", Napi::Number::New(env, static_cast<double>(snapshot.callbacks)));
+    result.Set("throttles", Napi::Number::New(env, static_cast<double>(snapshot.throttles)));
+    result.Set("resizes", Napi::Number::New(env, static_cast<double>(snapshot.resizes)));
+    result.Set("framedBytes", Napi::Number::New(env, static_cast<double>(snapshot.framedBytes)));
+    result.Set("queueDepth", Napi::Number::New(env, static_cast<double>(std::max<int64_t>(snapshot.queueDepth, 0))));
+    result.Set("peakQueueDepth", Napi::Number::New(env, static_cast<double>(snapshot.peakQueueDepth)));
+
+    Napi::Array buckets = Napi::Array::New(env, stats::LatencyHistogram::kBuckets);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < stats::LatencyHistogram::kBuckets; i++)
+    {
+        cumulative += snapshot.latencyBuckets[i];
+        bool last = i == stats::LatencyHistogram::kBuckets - 1;
+        Napi::Object bucket = Napi::Object::New(env);
+        bucket.Set("le", Napi::Number::New(env, last
+            ? std::numeric_limits<double>::infinity()
+            : static_cast<double>(stats::LatencyHistogram::UpperBound(i))));
+        bucket.Set("count", Napi::Number::New(env, static_cast<double>(cumulative)));
+        buckets.Set(static_cast<uint32_t>(i), bucket);
+    }
+    Napi::Object latency = Napi::Object::New(env);
+    latency.Set("count", Napi::Number::New(env, static_cast<double>(snapshot.latencyCount)));
+    latency.Set("sumMicros", Napi::Number::New(env, static_cast<double>(snapshot.latencySumMicros)));
+    latency.Set("buckets", buckets);
+    result.Set("latency", latency);
+    return result;
+}
+
+Napi::Value WebTerminal::GetStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-        std::wstring shellPath = L"powershell.exe";
-        std::cout << "Starting shell at: powershell.exe" << std::endl;
+    stats::Snapshot snapshot;
+    counters.AddTo(&snapshot);
+    Napi::Object result = StatsToObject(env, snapshot);
+    result.Set("queuedBytes", Napi::Number::New(env, static_cast<double>(queuedBytes.load())));
+    result.Set("processLifetimeMs", Napi::Number::New(env, counters.ProcessLifetimeMs()));
+    return result;
+}
+
+Napi::Value WebTerminal::Detach(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
+    if (!initialized)
+    {
+        throw Napi::Error::New(env, "Process not started");
+    }
+    if (starting)
+    {
+        throw Napi::Error::New(env, "Process still starting");
+    }
 
-        if (!pty->Start(shellPath))
+    double timeout = 30000;
+    if (info.Length() > 0 && info[0].IsObject() && info[0].As<Napi::Object>().Has("timeout"))
+    {
+        timeout = info[0].As<Napi::Object>().Get("timeout").As<Napi::Number>().DoubleValue();
+        if (!(timeout > 0))
         {
-            running = false;
-            DWORD error = GetLastError();
-            std::cout << "Failed to start shell with error: " << error << std::endl;
-            throw Napi::Error::New(env, "Failed to start process: " + std::to_string(error));
+            throw Napi::RangeError::New(env, "timeout must be positive");
         }
-
-        // Vérifier que le processus est bien démarré
-        if (pty->GetProcessId() == 0)
+    }
+    {
+        // Les rappels de write() ne suivent pas le PTY
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (!writeQueue.Empty())
         {
-            running = false;
-            throw Napi::Error::New(env, "Process started but no PID obtained");
+            throw Napi::Error::New(env, "Input still pending");
         }
+    }
 
-        // Attendre l'initialisation
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    pty->UnwatchExit();
+    if (childExited.load())
+    {
+        // La fin est déjà en route vers onExit() : rien à transmettre
+        throw Napi::Error::New(env, "Process exited");
+    }
 
-        processId = pty->GetProcessId();
-        initialized = true;
+    tornDown = true;
+    detached = true;
+    StopIo();
+    if (resizeScheduled)
+    {
+        // Minuterie arrêtée : le dernier resize() part maintenant
+        ApplyPendingResize();
+    }
+    pty->ResumeIo();
 
-        // Vérifier que le processus est toujours en vie
-        HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, processId);
-        if (hProcess != NULL)
-        {
-            DWORD exitCode;
-            if (GetExitCodeProcess(hProcess, &exitCode) && exitCode != STILL_ACTIVE)
-            {
-                CloseHandle(hProcess);
-                running = false;
-                throw Napi::Error::New(env, "Process terminated prematurely");
-            }
-            CloseHandle(hProcess);
-        }
+    backend::DetachedPty parked;
+    parked.pty = std::move(pty);
+    parked.cols = appliedCols;
+    parked.rows = appliedRows;
+    uint32_t token = backend::PtyHandoff::Instance().Park(
+        std::move(parked), std::chrono::milliseconds(static_cast<int64_t>(timeout)));
+    LOG_INFO("Process " << processId << " detached with token " << token);
+    return Napi::Number::New(env, token);
+}
 
-        std::cout << "Process started with PID: " << processId << std::endl;
+Napi::Value WebTerminal::Attach(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
 
-        return Napi::Number::New(env, processId);
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
     }
-    catch (const std::exception &e)
+    if (initialized || running.load() || starting)
     {
-        running = false;
-        std::cerr << "Error in StartProcess: " << e.what() << std::endl;
-        throw Napi::Error::New(env, e.what());
+        throw Napi::Error::New(env, "Process already started");
+    }
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "Terminal token expected");
+    }
+
+    backend::DetachedPty parked;
+    if (!backend::PtyHandoff::Instance().Claim(info[0].As<Napi::Number>().Uint32Value(), &parked))
+    {
+        throw Napi::Error::New(env, "Unknown or expired terminal token");
+    }
+
+    if (emulator)
+    {
+        emulator->Resize(parked.cols, parked.rows);
+    }
+    if (recorder)
+    {
+        recorder->RecordResize(parked.cols, parked.rows);
     }
+    {
+        std::lock_guard<std::mutex> lock(resizeMutex);
+        appliedCols = parked.cols;
+        appliedRows = parked.rows;
+    }
+    running = true;
+    counters.processStarted.store(stats::NowNs(), std::memory_order_relaxed);
+    InstallPty(std::move(parked.pty));
+    LOG_INFO("Process " << processId << " attached");
+    return env.Undefined();
 }
 
-Napi::Value WebTerminal::Write(const Napi::CallbackInfo &info)
+void ResizeTimer::OnTick() {
+    owner->ApplyPendingResize();
+}
+
+// Appelé sous resizeMutex, depuis JS ou la minuterie
+void WebTerminal::ApplyResize(int16_t cols, int16_t rows) {
+    lastResize = std::chrono::steady_clock::now();
+    if (cols == appliedCols && rows == appliedRows) {
+        return;
+    }
+    if (!pty->Resize(cols, rows)) {
+        throw std::runtime_error("Resize failed");
+    }
+    appliedCols = cols;
+    appliedRows = rows;
+    stats::Bump(counters.resizes);
+    if (emulator) {
+        emulator->Resize(cols, rows);
+    }
+    if (recorder) {
+        recorder->RecordResize(cols, rows);
+    }
+}
+
+void WebTerminal::ApplyPendingResize() {
+    std::lock_guard<std::mutex> lock(resizeMutex);
+    resizeScheduled = false;
+    try {
+        ApplyResize(pendingCols, pendingRows);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Deferred resize to " << pendingCols << "x" << pendingRows << " failed: " << e.what());
+    }
+}
+
+Napi::Value WebTerminal::Resize(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
+    if (tornDown)
+    {
+        throw Napi::Error::New(env, detached ? "Terminal detached" : "Process exited");
+    }
     if (!pty)
     {
         throw Napi::Error::New(env, "PTY not initialized");
     }
 
-    if (info.Length() < 1 || !info[0].IsString())
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
     {
-        throw Napi::TypeError::New(env, "String expected");
+        throw Napi::TypeError::New(env, "Numbers expected for columns and rows");
     }
 
     try
     {
-        std::string data = info[0].As<Napi::String>().Utf8Value();
-        DWORD written;
-        if (!pty->Write(data.c_str(), static_cast<DWORD>(data.length()), &written))
+        int16_t cols = static_cast<int16_t>(info[0].As<Napi::Number>().Int32Value());
+        int16_t rows = static_cast<int16_t>(info[1].As<Napi::Number>().Int32Value());
+
+        std::lock_guard<std::mutex> lock(resizeMutex);
+        pendingCols = cols;
+        pendingRows = rows;
+        if (resizeScheduled)
         {
-            std::cout << "Write failed with error: " << GetLastError() << std::endl;
-            throw std::runtime_error("Write failed");
+            // La minuterie prendra la dernière taille
+            return env.Undefined();
         }
 
+        auto elapsed = std::chrono::steady_clock::now() - lastResize;
+        if (elapsed >= kResizeWindow)
+        {
+            ApplyResize(cols, rows);
+        }
+        else
+        {
+            resizeScheduled = true;
+            io::Ticker::Instance().Schedule(
+                &resizeTimer,
+                kResizeWindow - std::chrono::duration_cast<std::chrono::milliseconds>(elapsed));
+        }
         return env.Undefined();
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Error in Write: " << e.what() << std::endl;
+        LOG_ERROR("Error in Resize: " << e.what());
         throw Napi::Error::New(env, e.what());
     }
 }
 
-Napi::Value WebTerminal::OnData(const Napi::CallbackInfo &info)
+Napi::Value WebTerminal::Echo(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsFunction())
+    if (info.Length() < 1 || !info[0].IsString())
     {
-        throw Napi::TypeError::New(env, "Function expected");
+        Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    std::cout << "Setting up data callback" << std::endl;
-    tsfn = Napi::ThreadSafeFunction::New(
-        env,
-        info[0].As<Napi::Function>(),
-        "Terminal Callback",
-        0,
-        1);
+    return info[0];
+}
 
-    readThread = std::thread([this]()
-                             { this->ReadLoop(); });
+static Napi::Value GetBufferPoolStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    io::BufferPoolStats stats = io::BufferPool::Instance().GetStats();
 
-    return env.Undefined();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("acquires", Napi::Number::New(env, static_cast<double>(stats.acquires)));
+    result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+    result.Set("blocksInUse", Napi::Number::New(env, static_cast<double>(stats.blocksInUse)));
+    result.Set("bytesInUse", Napi::Number::New(env, static_cast<double>(stats.bytesInUse)));
+    result.Set("peakBytesInUse", Napi::Number::New(env, static_cast<double>(stats.peakBytesInUse)));
+    result.Set("bytesRetained", Napi::Number::New(env, static_cast<double>(stats.bytesRetained)));
+    result.Set("maxBytesRetained", Napi::Number::New(env, static_cast<double>(stats.maxBytesRetained)));
+    return result;
 }
 
-Napi::Value WebTerminal::Resize(const Napi::CallbackInfo &info)
+static Napi::Value GetGlobalStats(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    if (!pty)
+    size_t live;
+    uint64_t created;
+    stats::Snapshot snapshot = stats::Registry::Instance().Aggregate(&live, &created);
+    Napi::Object result = StatsToObject(env, snapshot);
+    result.Set("terminals", Napi::Number::New(env, static_cast<double>(live)));
+    result.Set("terminalsCreated", Napi::Number::New(env, static_cast<double>(created)));
+    return result;
+}
+
+static Napi::Value ConfigureReactor(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
     {
-        throw Napi::Error::New(env, "PTY not initialized");
+        throw Napi::TypeError::New(env, "Object expected");
     }
 
-    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (options.Has("threads"))
     {
-        throw Napi::TypeError::New(env, "Numbers expected for columns and rows");
+        int32_t threads = options.Get("threads").As<Napi::Number>().Int32Value();
+        if (threads <= 0)
+        {
+            throw Napi::RangeError::New(env, "threads must be positive");
+        }
+        if (!io::Reactor::Instance().SetThreadCount(static_cast<unsigned>(threads)))
+        {
+            throw Napi::Error::New(env, "Reactor already started");
+        }
     }
 
-    try
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("available", Napi::Boolean::New(env, io::Reactor::Available()));
+    result.Set("threads", Napi::Number::New(env, io::Reactor::Instance().GetThreadCount()));
+    return result;
+}
+
+static Napi::Value ConfigureBufferPool(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
     {
-        SHORT cols = static_cast<SHORT>(info[0].As<Napi::Number>().Int32Value());
-        SHORT rows = static_cast<SHORT>(info[1].As<Napi::Number>().Int32Value());
+        throw Napi::TypeError::New(env, "Object expected");
+    }
 
-        if (!pty->Resize(cols, rows))
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (options.Has("maxRetainedBytes"))
+    {
+        double bytes = options.Get("maxRetainedBytes").As<Napi::Number>().DoubleValue();
+        if (bytes < 0)
         {
-            throw std::runtime_error("Resize failed");
+            throw Napi::RangeError::New(env, "maxRetainedBytes must not be negative");
         }
+        io::BufferPool::Instance().SetMaxRetained(static_cast<size_t>(bytes));
+    }
 
-        return env.Undefined();
+    return env.Undefined();
+}
+
+static Napi::Value ConfigurePtyPool(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        throw Napi::TypeError::New(env, "Object expected");
     }
-    catch (const std::exception &e)
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    double size = options.Has("size") ? options.Get("size").As<Napi::Number>().DoubleValue() : 0;
+    double maxIdleMs = options.Has("maxIdleMs") ? options.Get("maxIdleMs").As<Napi::Number>().DoubleValue() : 300000;
+    if (size < 0 || maxIdleMs < 0)
     {
-        std::cerr << "Error in Resize: " << e.what() << std::endl;
-        throw Napi::Error::New(env, e.what());
+        throw Napi::RangeError::New(env, "size and maxIdleMs must not be negative");
+    }
+
+    std::vector<backend::PtyPoolProfile> profiles;
+    if (options.Has("profiles"))
+    {
+        if (!options.Get("profiles").IsArray())
+        {
+            throw Napi::TypeError::New(env, "profiles must be an array");
+        }
+        Napi::Array list = options.Get("profiles").As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); i++)
+        {
+            Napi::Object entry = list.Get(i).As<Napi::Object>();
+            backend::PtyPoolProfile profile;
+            profile.command = entry.Has("command") ? entry.Get("command").ToString().Utf8Value() : backend::DefaultShell();
+            profile.cols = static_cast<int16_t>(entry.Has("cols") ? entry.Get("cols").As<Napi::Number>().Int32Value() : 120);
+            profile.rows = static_cast<int16_t>(entry.Has("rows") ? entry.Get("rows").As<Napi::Number>().Int32Value() : 30);
+            profiles.push_back(profile);
+        }
+    }
+    else
+    {
+        profiles.push_back(backend::PtyPoolProfile{backend::DefaultShell(), 120, 30});
     }
+
+    backend::PtyPool::Instance().Configure(static_cast<size_t>(size),
+                                           std::chrono::milliseconds(static_cast<int64_t>(maxIdleMs)),
+                                           profiles);
+    return env.Undefined();
 }
 
-Napi::Value WebTerminal::Echo(const Napi::CallbackInfo &info)
+static Napi::Value GetPtyPoolStats(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
+    backend::PtyPoolStats stats = backend::PtyPool::Instance().GetStats();
 
-    if (info.Length() < 1 || !info[0].IsString())
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+    result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+    result.Set("spawned", Napi::Number::New(env, static_cast<double>(stats.spawned)));
+    result.Set("expired", Napi::Number::New(env, static_cast<double>(stats.expired)));
+    result.Set("failed", Napi::Number::New(env, static_cast<double>(stats.failed)));
+    result.Set("idle", Napi::Number::New(env, static_cast<double>(stats.idle)));
+    return result;
+}
+
+static Napi::Value ConfigureLogger(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() > 0 && info[0].IsObject())
     {
-        Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
-        return env.Null();
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("level"))
+        {
+            Logger::Level level;
+            if (!Logger::ParseLevel(options.Get("level").ToString().Utf8Value(), &level))
+            {
+                throw Napi::TypeError::New(env, "level must be 'debug', 'info', 'warning', 'error' or 'off'");
+            }
+            Logger::SetLevel(level);
+        }
+        if (options.Has("file"))
+        {
+            Napi::Value file = options.Get("file");
+            std::string path = file.IsString() ? file.As<Napi::String>().Utf8Value() : "";
+            if (!Logger::SetFile(path))
+            {
+                throw Napi::Error::New(env, "Failed to open log file " + path + ": " + strerror(errno));
+            }
+        }
+        if (options.Has("console"))
+        {
+            Logger::SetConsole(options.Get("console").ToBoolean());
+        }
     }
 
-    return info[0];
+    std::string level = Logger::LevelName(Logger::GetLevel());
+    std::transform(level.begin(), level.end(), level.begin(), ::tolower);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("level", Napi::String::New(env, level));
+    return result;
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    // Les derniers messages sont écrits avant le déchargement du module
+    env.AddCleanupHook([]() { Logger::Flush(); });
+
+    exports.Set("configureLogger", Napi::Function::New(env, ConfigureLogger));
+    exports.Set("getBufferPoolStats", Napi::Function::New(env, GetBufferPoolStats));
+    exports.Set("getGlobalStats", Napi::Function::New(env, GetGlobalStats));
+    exports.Set("configureBufferPool", Napi::Function::New(env, ConfigureBufferPool));
+    exports.Set("configureReactor", Napi::Function::New(env, ConfigureReactor));
+    exports.Set("configurePtyPool", Napi::Function::New(env, ConfigurePtyPool));
+    exports.Set("getPtyPoolStats", Napi::Function::New(env, GetPtyPoolStats));
     return WebTerminal::Init(env, exports);
 }
 
@@ -2,14 +2,104 @@
 #include <napi.h>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <memory>
-#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include "io/reactor.h"
+#include "io/scrollback.h"
+#include "io/ticker.h"
+#include "io/write_queue.h"
+#include "pty_backend.h"
+#include "stats.h"
+#include "vt/emulator.h"
+#include "vt/triggers.h"
+#include <deque>
+#include <map>
+#include <vector>
 
-namespace conpty {
-    class ConPTY;
+namespace io {
+    struct Block;
+    class Recorder;
+    class SharedRing;
+    class FrameEncoder;
 }
 
-class WebTerminal : public Napi::ObjectWrap<WebTerminal> {
+class WebTerminal;
+class StartWorker;
+
+// Minuterie du regroupement des resize(), distincte du tick des trames
+struct ResizeTimer : public io::TickHandler {
+    WebTerminal* owner;
+    void OnTick() override;
+};
+
+// Contexte de la TSFN de sortie. Il survit au terminal jusqu'à la
+// finalisation de la TSFN, owner passe alors à nullptr.
+struct OutputChannel {
+    WebTerminal* owner;
+    bool utf8;
+
+    static void Deliver(Napi::Env env, Napi::Function callback, OutputChannel* channel, io::Block* block);
+};
+
+using OutputFunction = Napi::TypedThreadSafeFunction<OutputChannel, io::Block, &OutputChannel::Deliver>;
+
+// Abonné supplémentaire (subscribe) : il reçoit les mêmes blocs que onData,
+// sans copie. S'il ne suit pas, il décroche et rattrape depuis l'historique
+// au lieu de freiner la lecture du PTY.
+struct Subscriber {
+    WebTerminal* owner;
+    uint32_t id;
+    size_t maxQueuedBytes;
+    std::atomic<size_t> queuedBytes;
+    std::atomic<bool> lagging;
+    // Protégés par WebTerminal::subscribersMutex : prochain octet attendu,
+    // et TSFN déjà relâchée
+    uint64_t cursor;
+    bool closed;
+
+    static void Deliver(Napi::Env env, Napi::Function callback, Subscriber* subscriber, io::Block* block);
+    Napi::TypedThreadSafeFunction<Subscriber, io::Block, &Subscriber::Deliver> tsfn;
+};
+
+// Évènement natif remonté vers JS en dehors du flux de sortie
+struct TerminalEvent {
+    enum Type { WriteProgress, WriteError, Drain, Exit, Trigger, RingWake };
+    Type type;
+    uint64_t value;
+    // Trigger : identifiant du déclencheur, value étant la position dans le flux
+    uint32_t trigger;
+};
+
+struct EventChannel {
+    WebTerminal* owner;
+
+    static void Dispatch(Napi::Env env, Napi::Function callback, EventChannel* channel, TerminalEvent* event);
+};
+
+using EventFunction = Napi::TypedThreadSafeFunction<EventChannel, TerminalEvent, &EventChannel::Dispatch>;
+
+// Trames de l'écran (onFrame), même principe que OutputChannel
+struct FrameChannel {
+    WebTerminal* owner;
+
+    static void Deliver(Napi::Env env, Napi::Function callback, FrameChannel* channel, std::string* frame);
+};
+
+using FrameFunction = Napi::TypedThreadSafeFunction<FrameChannel, std::string, &FrameChannel::Deliver>;
+
+class WebTerminal : public Napi::ObjectWrap<WebTerminal>, private io::IoHandler, private io::TickHandler,
+                    private backend::ExitListener {
+    friend struct OutputChannel;
+    friend struct EventChannel;
+    friend struct FrameChannel;
+    friend struct Subscriber;
+    friend struct ResizeTimer;
+    friend class StartWorker;
+
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     WebTerminal(const Napi::CallbackInfo& info);
@@ -18,15 +108,233 @@ public:
 private:
     Napi::Value StartProcess(const Napi::CallbackInfo& info);
     Napi::Value Write(const Napi::CallbackInfo& info);
+    Napi::Value Paste(const Napi::CallbackInfo& info);
     Napi::Value OnData(const Napi::CallbackInfo& info);
+    Napi::Value OnDrain(const Napi::CallbackInfo& info);
+    Napi::Value OnFrame(const Napi::CallbackInfo& info);
+    Napi::Value OnExit(const Napi::CallbackInfo& info);
+    Napi::Value Subscribe(const Napi::CallbackInfo& info);
+    Napi::Value Unsubscribe(const Napi::CallbackInfo& info);
+    Napi::Value SetOutputRing(const Napi::CallbackInfo& info);
+    Napi::Value AddTrigger(const Napi::CallbackInfo& info);
+    Napi::Value RemoveTrigger(const Napi::CallbackInfo& info);
     Napi::Value Resize(const Napi::CallbackInfo& info);
     Napi::Value Echo(const Napi::CallbackInfo& info);
+    Napi::Value Pause(const Napi::CallbackInfo& info);
+    Napi::Value Resume(const Napi::CallbackInfo& info);
+    Napi::Value GetQueuedBytes(const Napi::CallbackInfo& info);
+    Napi::Value GetScrollback(const Napi::CallbackInfo& info);
+    Napi::Value ExportSnapshot(const Napi::CallbackInfo& info);
+    Napi::Value ImportSnapshot(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value Detach(const Napi::CallbackInfo& info);
+    Napi::Value Attach(const Napi::CallbackInfo& info);
+
+    enum class ReadStatus { Data, Idle, Closed, Failed };
+    enum class ReadyMode { Exec, Output, Pattern };
+
+    bool SpawnProcess(int16_t cols, int16_t rows, const backend::SpawnOptions& options,
+                      std::unique_ptr<backend::PtyBackend>* spawned, std::string* error);
+    void OnProcessSpawned(Napi::Env env, Napi::Promise::Deferred deferred, std::unique_ptr<backend::PtyBackend> spawned);
+    void InstallPty(std::unique_ptr<backend::PtyBackend> spawned);
+    void CheckReady(Napi::Env env, const char* data, size_t size);
+    void SettleStart(Napi::Env env, Napi::Value error);
+
+    void OnProcessExit(int code, int signal) override;
+    void MaybeFinishExit(Napi::Env env);
+    void Teardown();
+    void StopIo();
+    static void OnEnvCleanup(void* arg);
+
+    void StartIo();
     void ReadLoop();
+    void OnReadable() override;
+    bool WantsRead() override;
+    void UpdateReading();
+    void OnOutputDelivered(size_t size);
+    ReadStatus ReadChunk(bool wait, uint32_t* bytesRead);
+    void FlushPending();
+    void FinishOutput();
+    void SendOutput(io::Block* block, std::chrono::steady_clock::time_point readAt);
+    void PostOutput(io::Block* block);
+    bool HasReaders() const;
+    void FanOut(io::Block* block);
+    void CatchUp(Subscriber* subscriber);
+    void CatchUpLocked(Subscriber* subscriber);
+    void CloseSubscribers();
+    void ScanTriggers();
+    void PublishTriggers();
+    bool DropTrigger(uint32_t id);
+
+    void WriteLoop();
+    void OnWritable() override;
+    bool WantsWrite() override;
+    void FlushInput();
+    void FailInput(unsigned long error);
+    void NotifyInputProgress();
+    void PostEvent(TerminalEvent::Type type, uint64_t value, uint32_t trigger = 0);
+    void HandleEvent(Napi::Env env, const TerminalEvent& event);
+    void CompleteWrites(Napi::Value error);
+    void AddWriteCallback(uint64_t end, Napi::Function callback);
+    void KickInput();
+    void ApplyResize(int16_t cols, int16_t rows);
+    void ApplyPendingResize();
+    void SyncWriteCallbacks();
 
-    std::unique_ptr<conpty::ConPTY> pty;
+    void OnTick() override;
+
+    std::unique_ptr<backend::PtyBackend> pty;
     std::atomic<bool> running;
     bool initialized;
-    DWORD processId;
+    uint32_t processId;
     std::thread readThread;
-    Napi::ThreadSafeFunction tsfn;
+    OutputFunction tsfn;
+    OutputChannel* channel;
+    EventFunction events;
+    EventChannel* eventChannel;
+    std::atomic<bool> hasCallback;
+    bool ioStarted;
+    bool outputFinished;
+
+    // startProcess() : la promesse attend, selon readyMode, l'exec, la
+    // première sortie ou le motif readyText / readyPattern (RegExp).
+    bool starting;
+    ReadyMode readyMode;
+    std::unique_ptr<Napi::Promise::Deferred> startDeferred;
+    std::string readyText;
+    Napi::ObjectReference readyPattern;
+    std::string readyBuffer;
+
+    // Fin du processus : childExited est posé par le thread de surveillance,
+    // onExit() n'est appelé qu'une fois toute la sortie livrée (outputDone).
+    std::atomic<bool> childExited;
+    bool exitReported;
+    bool outputDone;
+    bool exitFired;
+    bool tornDown;
+    // PTY passé à un autre terminal par detach()
+    bool detached;
+    // Environnement (worker) en cours de fermeture : le crochet est déjà parti
+    bool envClosed;
+    int exitCode;
+    int exitSignal;
+    Napi::FunctionReference exitCallback;
+
+    // Sous Linux les E/S passent par le réacteur partagé plutôt que par
+    // readThread/writeThread
+    io::Registration* registration;
+
+    // Contre-pression : au-delà de maxQueuedBytes en attente côté JS on
+    // arrête de lire, et on reprend une fois redescendu sous la moitié.
+    std::atomic<bool> paused;
+    std::atomic<bool> throttled;
+    std::atomic<bool> readClosed;
+    std::atomic<size_t> queuedBytes;
+    // Options d'onData() : atomiques car subscribe() ou setOutputRing()
+    // peuvent avoir lancé la lecture avant
+    std::atomic<size_t> maxQueuedBytes;
+    std::mutex flowMutex;
+    std::condition_variable flowCv;
+
+    // Regroupement de la sortie (désactivé si maxLatency vaut 0)
+    std::atomic<std::chrono::milliseconds> coalesceLatency;
+    std::atomic<size_t> coalesceMaxBatch;
+
+    // Découpage sur les frontières UTF-8 / séquences (option framing)
+    std::atomic<bool> framing;
+
+    // onData en trames binaires (encoding: 'frame'), construites et
+    // compressées par le thread de lecture
+    std::unique_ptr<io::FrameEncoder> frameEncoder;
+
+    // État de lecture, touché par un seul thread à la fois (readThread ou réacteur)
+    uint32_t readSize;
+    uint32_t shortReads;
+    io::Block* pending;
+    std::chrono::steady_clock::time_point pendingSince;
+
+    // Entrée : file native vidée par le réacteur (ou writeThread) ; les
+    // rappels de write() sont résolus par position dans le flux.
+    struct PendingWrite {
+        uint64_t end;
+        Napi::FunctionReference callback;
+    };
+    std::thread writeThread;
+    std::mutex writeMutex;
+    std::condition_variable writeCv;
+    io::WriteQueue writeQueue;
+    std::atomic<bool> inputPending;
+    std::atomic<bool> inputFailed;
+    bool drainWanted;
+    std::atomic<uint64_t> bytesWritten;
+    std::atomic<uint64_t> nextWriteCallback;
+    std::deque<PendingWrite> writeCallbacks;
+    Napi::FunctionReference drainCallback;
+
+    // resize() en rafale (glisser de fenêtre) : le premier part tout de
+    // suite, les suivants dans la fenêtre se résument au dernier
+    std::mutex resizeMutex;
+    ResizeTimer resizeTimer;
+    bool resizeScheduled;
+    int16_t pendingCols;
+    int16_t pendingRows;
+    int16_t appliedCols;
+    int16_t appliedRows;
+    std::chrono::steady_clock::time_point lastResize;
+
+    // Historique de la sortie pour les clients qui se reconnectent
+    io::Scrollback scrollback;
+
+    // Abonnés de subscribe(), servis par la même lecture que onData. Le
+    // mutex couvre aussi l'ajout à scrollback : un abonné qui rattrape voit
+    // l'historique et les blocs suivants sans trou ni doublon.
+    std::mutex subscribersMutex;
+    std::vector<Subscriber*> subscribers;
+    std::atomic<uint32_t> subscriberCount;
+    uint32_t nextSubscriberId;
+    bool subscribersClosed;
+
+    // Anneau partagé de setOutputRing(), écrit par FanOut() sous le même
+    // verrou. Atomics.notify() n'existe que côté JS : un consommateur qui
+    // attend est réveillé par un évènement RingWake, pas à chaque bloc.
+    std::unique_ptr<io::SharedRing> ring;
+    std::atomic<bool> hasRing;
+    Napi::ObjectReference ringView;
+    Napi::ObjectReference ringWords;
+
+    // Déclencheurs (addTrigger) : motifs et rappels vivent côté JS, la
+    // lecture ne voit que l'automate compilé, remplacé en bloc à chaque
+    // modification et récupéré quand triggersVersion change.
+    struct TriggerCallback {
+        Napi::FunctionReference callback;
+        bool once;
+    };
+    std::vector<vt::TriggerSet::Pattern> triggerPatterns;
+    std::map<uint32_t, TriggerCallback> triggerCallbacks;
+    uint32_t nextTriggerId;
+    std::mutex triggersMutex;
+    std::shared_ptr<const vt::TriggerSet> publishedTriggers;
+    std::atomic<uint64_t> triggersVersion;
+    // Côté lecture : triggerScanned octets de pending déjà passés à l'automate
+    std::shared_ptr<const vt::TriggerSet> activeTriggers;
+    uint64_t activeTriggersVersion;
+    vt::TriggerSet::State triggerState;
+    size_t triggerScanned;
+    std::vector<vt::TriggerSet::Match> triggerMatches;
+
+    // Modèle d'écran (option screen), nul si désactivé
+    std::unique_ptr<vt::Emulator> emulator;
+
+    // Flux de trames : au plus kMaxFramesInFlight en attente côté JS, les
+    // modifications suivantes s'accumulent dans la trame d'après.
+    FrameFunction frames;
+    FrameChannel* frameChannel;
+    bool hasFrameCallback;
+    std::atomic<int> framesInFlight;
+
+    // Enregistrement de la session (option record), nul si désactivé
+    std::unique_ptr<io::Recorder> recorder;
+
+    // Compteurs exposés par getStats(), agrégés par stats::Registry
+    stats::TerminalCounters counters;
 };
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "unix/exit_monitor.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace unixpty {
+
+#ifdef __linux__
+static int OpenPidFd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+#endif
+
+// Terminé sans être récolté : le statut reste pour waitpid()
+static bool HasTerminated(pid_t pid) {
+    siginfo_t info = {};
+    if (waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOHANG | WNOWAIT) != 0) {
+        // ECHILD : déjà récolté ailleurs
+        return errno == ECHILD;
+    }
+    return info.si_pid == pid;
+}
+
+ExitMonitor &ExitMonitor::Instance() {
+    // Jamais détruit, comme le réacteur
+    static ExitMonitor *monitor = new ExitMonitor();
+    return *monitor;
+}
+
+ExitMonitor::ExitMonitor()
+    : nextId(1),
+      notifying(nullptr),
+      queueFd(-1),
+      wakeRead(-1),
+      wakeWrite(-1),
+      started(false) {
+}
+
+bool ExitMonitor::Start() {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    for (int fd : fds) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    wakeRead = fds[0];
+    wakeWrite = fds[1];
+
+#ifdef __linux__
+    queueFd = epoll_create1(EPOLL_CLOEXEC);
+    if (queueFd >= 0) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = 0;
+        epoll_ctl(queueFd, EPOLL_CTL_ADD, wakeRead, &ev);
+    }
+#else
+    queueFd = kqueue();
+    if (queueFd >= 0) {
+        struct kevent change;
+        EV_SET(&change, wakeRead, EVFILT_READ, EV_ADD, 0, 0, nullptr);
+        kevent(queueFd, &change, 1, nullptr, 0, nullptr);
+    }
+#endif
+    if (queueFd < 0) {
+        close(wakeRead);
+        close(wakeWrite);
+        wakeRead = wakeWrite = -1;
+        return false;
+    }
+
+    std::thread([this]() { Run(); }).detach();
+    return true;
+}
+
+bool ExitMonitor::Watch(pid_t pid, ExitWatcher *watcher) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!started) {
+        if (!Start()) {
+            return false;
+        }
+        started = true;
+    }
+
+    Entry entry{nextId++, pid, watcher, -1, true};
+#ifdef __linux__
+    entry.fd = OpenPidFd(pid);
+    if (entry.fd >= 0) {
+        fcntl(entry.fd, F_SETFD, FD_CLOEXEC);
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = entry.id;
+        if (epoll_ctl(queueFd, EPOLL_CTL_ADD, entry.fd, &ev) == 0) {
+            entry.polled = false;
+        } else {
+            close(entry.fd);
+            entry.fd = -1;
+        }
+    }
+#else
+    // ESRCH : déjà terminé, le prochain passage le verra par waitid()
+    struct kevent change;
+    EV_SET(&change, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, reinterpret_cast<void *>(static_cast<uintptr_t>(entry.id)));
+    entry.polled = kevent(queueFd, &change, 1, nullptr, 0, nullptr) != 0;
+#endif
+    entries.push_back(entry);
+    // Le thread réévalue son délai d'attente
+    Wake();
+    return true;
+}
+
+void ExitMonitor::Unwatch(ExitWatcher *watcher) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->watcher != watcher) {
+            continue;
+        }
+#ifdef __linux__
+        if (it->fd >= 0) {
+            epoll_ctl(queueFd, EPOLL_CTL_DEL, it->fd, nullptr);
+            close(it->fd);
+        }
+#else
+        if (!it->polled) {
+            struct kevent change;
+            EV_SET(&change, it->pid, EVFILT_PROC, EV_DELETE, 0, 0, nullptr);
+            kevent(queueFd, &change, 1, nullptr, 0, nullptr);
+        }
+#endif
+        entries.erase(it);
+        break;
+    }
+    idle.wait(lock, [this, watcher]() { return notifying != watcher; });
+}
+
+void ExitMonitor::Wake() {
+    char byte = 1;
+    ssize_t ignored = write(wakeWrite, &byte, 1);
+    (void)ignored;
+}
+
+void ExitMonitor::Notify(uint64_t id, std::unique_lock<std::mutex> &lock) {
+    // Unwatch() a pu passer depuis l'évènement
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [id](const Entry &entry) { return entry.id == id; });
+    if (it == entries.end()) {
+        return;
+    }
+    ExitWatcher *watcher = it->watcher;
+#ifdef __linux__
+    if (it->fd >= 0) {
+        epoll_ctl(queueFd, EPOLL_CTL_DEL, it->fd, nullptr);
+        close(it->fd);
+    }
+#endif
+    entries.erase(it);
+
+    // Une seule notification par processus, appelée hors verrou
+    notifying = watcher;
+    lock.unlock();
+    watcher->OnChildExit();
+    lock.lock();
+    notifying = nullptr;
+    idle.notify_all();
+}
+
+void ExitMonitor::Run() {
+    const int maxEvents = 64;
+
+    for (;;) {
+        bool polling;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            polling = std::any_of(entries.begin(), entries.end(),
+                                  [](const Entry &entry) { return entry.polled; });
+        }
+
+        std::vector<uint64_t> exited;
+        bool woken = false;
+#ifdef __linux__
+        struct epoll_event events[maxEvents];
+        int count = epoll_wait(queueFd, events, maxEvents, polling ? 100 : -1);
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.u64 != 0) {
+                exited.push_back(events[i].data.u64);
+            } else {
+                woken = true;
+            }
+        }
+#else
+        struct kevent events[maxEvents];
+        struct timespec timeout = {0, 100 * 1000 * 1000};
+        int count = kevent(queueFd, nullptr, 0, events, maxEvents, polling ? &timeout : nullptr);
+        for (int i = 0; i < count; i++) {
+            if (events[i].filter == EVFILT_PROC) {
+                exited.push_back(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(events[i].udata)));
+            } else {
+                woken = true;
+            }
+        }
+#endif
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR("ExitMonitor: wait failed: " << errno);
+            return;
+        }
+        if (woken) {
+            char buffer[64];
+            while (read(wakeRead, buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (const Entry &entry : entries) {
+            if (entry.polled && HasTerminated(entry.pid)) {
+                exited.push_back(entry.id);
+            }
+        }
+        for (uint64_t id : exited) {
+            Notify(id, lock);
+        }
+    }
+}
+
+} // namespace unixpty
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace unixpty {
+
+class ExitWatcher {
+public:
+    virtual ~ExitWatcher() {}
+    // Thread du moniteur ; le processus est terminé mais pas encore récolté
+    virtual void OnChildExit() = 0;
+};
+
+// Un seul thread surveille la fin de tous les shells : pidfd + epoll sous
+// Linux, kqueue (EVFILT_PROC) sous macOS/BSD. Sans pidfd (noyau < 5.3),
+// ces processus sont testés par waitid(WNOWAIT) toutes les 100 ms.
+class ExitMonitor {
+public:
+    static ExitMonitor &Instance();
+
+    bool Watch(pid_t pid, ExitWatcher *watcher);
+    // Synchrone : au retour, OnChildExit() n'est plus en cours ni appelé pour watcher
+    void Unwatch(ExitWatcher *watcher);
+
+private:
+    struct Entry {
+        // Clé des évènements : une adresse de watcher peut être réutilisée
+        // par un autre terminal avant qu'un évènement en attente soit lu
+        uint64_t id;
+        pid_t pid;
+        ExitWatcher *watcher;
+        // pidfd sous Linux, -1 sinon
+        int fd;
+        // Ni pidfd ni kqueue : testé par waitid() à chaque passage
+        bool polled;
+    };
+
+    ExitMonitor();
+    ExitMonitor(const ExitMonitor &) = delete;
+    ExitMonitor &operator=(const ExitMonitor &) = delete;
+
+    bool Start();
+    void Run();
+    void Wake();
+    void Notify(uint64_t id, std::unique_lock<std::mutex> &lock);
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::vector<Entry> entries;
+    // 0 est réservé au tube de réveil
+    uint64_t nextId;
+    ExitWatcher *notifying;
+    // epoll ou kqueue, et tube de réveil pour les changements de la liste
+    int queueFd;
+    int wakeRead;
+    int wakeWrite;
+    bool started;
+};
+
+} // namespace unixpty
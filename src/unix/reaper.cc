@@ -0,0 +1,58 @@
+#include "unix/reaper.h"
+#include "Logger/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <signal.h>
+#include <sys/wait.h>
+
+namespace unixpty {
+
+const std::chrono::milliseconds Reaper::kGracePeriod(500);
+static const std::chrono::milliseconds kPollInterval(20);
+
+Reaper &Reaper::Instance() {
+    // Jamais détruit, comme l'horloge qui l'appelle
+    static Reaper *reaper = new Reaper();
+    return *reaper;
+}
+
+Reaper::Reaper() : scheduled(false) {
+}
+
+void Reaper::Terminate(pid_t pid) {
+    kill(pid, SIGHUP);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    children.push_back(Child{pid, std::chrono::steady_clock::now() + kGracePeriod, false});
+    if (!scheduled) {
+        scheduled = true;
+        io::Ticker::Instance().Schedule(this, kPollInterval);
+    }
+}
+
+void Reaper::OnTick() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    children.erase(std::remove_if(children.begin(), children.end(), [now](Child &child) {
+        pid_t rc;
+        do {
+            rc = waitpid(child.pid, nullptr, WNOHANG);
+        } while (rc < 0 && errno == EINTR);
+        if (rc == child.pid || (rc < 0 && errno == ECHILD)) {
+            return true;
+        }
+        if (!child.killed && child.deadline <= now) {
+            LOG_DEBUG("PID " << child.pid << " ignored SIGHUP, sending SIGKILL");
+            kill(child.pid, SIGKILL);
+            child.killed = true;
+        }
+        return false;
+    }), children.end());
+
+    scheduled = !children.empty();
+    if (scheduled) {
+        io::Ticker::Instance().Schedule(this, kPollInterval);
+    }
+}
+
+} // namespace unixpty
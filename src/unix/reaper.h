@@ -0,0 +1,40 @@
+#pragma once
+#include "io/ticker.h"
+#include <chrono>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace unixpty {
+
+// Fin des processus dont le PTY est fermé : SIGHUP, un court délai pour
+// finir proprement (historique du shell...), puis SIGKILL. Le tout se fait
+// sur l'horloge partagée, sans bloquer le thread qui ferme.
+class Reaper : private io::TickHandler {
+public:
+    static const std::chrono::milliseconds kGracePeriod;
+
+    static Reaper &Instance();
+
+    // Le processus n'a pas encore été récolté ; il le sera ici
+    void Terminate(pid_t pid);
+
+private:
+    struct Child {
+        pid_t pid;
+        std::chrono::steady_clock::time_point deadline;
+        bool killed;
+    };
+
+    Reaper();
+    Reaper(const Reaper &) = delete;
+    Reaper &operator=(const Reaper &) = delete;
+
+    void OnTick() override;
+
+    std::mutex mutex;
+    std::vector<Child> children;
+    bool scheduled;
+};
+
+} // namespace unixpty
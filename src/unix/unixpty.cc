@@ -0,0 +1,544 @@
+#include "unix/unixpty.h"
+#include "unix/reaper.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <util.h>
+#elif defined(__FreeBSD__)
+#include <libutil.h>
+#else
+#include <pty.h>
+#endif
+
+// posix_spawn_file_actions_addchdir_np() arrive avec glibc 2.29
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define NEBULA_POSIX_SPAWN 1
+#include <spawn.h>
+#endif
+
+extern char **environ;
+
+namespace unixpty {
+
+static bool SetFlags(int fd, bool nonBlocking) {
+    int fdFlags = fcntl(fd, F_GETFD);
+    if (fdFlags < 0 || fcntl(fd, F_SETFD, fdFlags | FD_CLOEXEC) < 0) {
+        return false;
+    }
+    if (!nonBlocking) {
+        return true;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+UnixPTY::UnixPTY()
+    : masterFd(-1)
+    , slaveFd(-1)
+    , wakeRead(-1)
+    , wakeWrite(-1)
+    , pid(0)
+    , exited(false)
+    , exitCode(0)
+    , exitSignal(0)
+    , exitListener(nullptr)
+    , isInitialized(false) {
+}
+
+UnixPTY::~UnixPTY() {
+    Close();
+}
+
+bool UnixPTY::IsActive() const {
+    return masterFd >= 0;
+}
+
+bool UnixPTY::CreateWakePipe() {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    wakeRead = fds[0];
+    wakeWrite = fds[1];
+    return SetFlags(wakeRead, true) && SetFlags(wakeWrite, true);
+}
+
+bool UnixPTY::Create(int16_t cols, int16_t rows) {
+    if (isInitialized) {
+        return false;
+    }
+
+    struct winsize size = {};
+    size.ws_col = static_cast<unsigned short>(cols);
+    size.ws_row = static_cast<unsigned short>(rows);
+
+    if (openpty(&masterFd, &slaveFd, nullptr, nullptr, &size) != 0) {
+        masterFd = slaveFd = -1;
+        return false;
+    }
+
+#ifdef IUTF8
+    // Équivalent de SetConsoleCP(CP_UTF8) : édition de ligne en UTF-8
+    struct termios attrs;
+    if (tcgetattr(slaveFd, &attrs) == 0) {
+        attrs.c_iflag |= IUTF8;
+        tcsetattr(slaveFd, TCSANOW, &attrs);
+    }
+#endif
+
+    // Le maître est non bloquant : les lectures attendent via poll()
+    if (!SetFlags(masterFd, true) || !SetFlags(slaveFd, false) || !CreateWakePipe()) {
+        Close();
+        return false;
+    }
+
+    isInitialized = true;
+    return true;
+}
+
+// Signaux que Node ignore ou masque : l'enfant repart des défauts
+static const int kDefaultSignals[] = { SIGPIPE, SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGCHLD };
+
+#ifdef NEBULA_POSIX_SPAWN
+// posix_spawn() de glibc passe par clone(CLONE_VM | CLONE_VFORK) : pas de
+// copie des tables de pages d'un gros processus Node, et l'échec de l'exec
+// est remonté directement. Après setsid(), ouvrir l'esclave sans O_NOCTTY
+// en fait le terminal de contrôle, à la place de l'ioctl TIOCSCTTY.
+static int SpawnChild(const char *slaveName, char *const *argv, char *const *envp, const std::string &cwd, pid_t *child) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int rc = posix_spawn_file_actions_init(&actions);
+    if (rc != 0) {
+        return rc;
+    }
+    rc = posix_spawnattr_init(&attr);
+    if (rc != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return rc;
+    }
+
+    sigset_t mask;
+    sigset_t defaults;
+    sigemptyset(&mask);
+    sigemptyset(&defaults);
+    for (int sig : kDefaultSignals) {
+        sigaddset(&defaults, sig);
+    }
+
+    if ((rc = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF)) == 0
+        && (rc = posix_spawnattr_setsigmask(&attr, &mask)) == 0
+        && (rc = posix_spawnattr_setsigdefault(&attr, &defaults)) == 0
+        && (rc = posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName, O_RDWR, 0)) == 0
+        && (rc = posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO)) == 0
+        && (rc = posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO)) == 0
+        && (cwd.empty() || (rc = posix_spawn_file_actions_addchdir_np(&actions, cwd.c_str())) == 0)) {
+        rc = posix_spawnp(child, argv[0], &actions, &attr, argv, envp);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc;
+}
+#endif
+
+// Repli sans posix_spawn() utilisable (macOS, anciennes glibc) : fork() + exec
+static int ForkChild(int slaveFd, char *const *argv, char **envp, const std::string &cwd, pid_t *result) {
+    // Tube fermé par exec (FD_CLOEXEC) : une fin de fichier signale un exec
+    // réussi, sinon l'enfant y écrit errno avant de sortir.
+    int status[2];
+    if (pipe(status) != 0) {
+        return errno;
+    }
+    if (!SetFlags(status[0], false) || !SetFlags(status[1], false)) {
+        int error = errno;
+        close(status[0]);
+        close(status[1]);
+        return error;
+    }
+
+    const char *directory = cwd.empty() ? nullptr : cwd.c_str();
+    pid_t child = fork();
+    if (child < 0) {
+        int error = errno;
+        close(status[0]);
+        close(status[1]);
+        return error;
+    }
+
+    if (child == 0) {
+        // Enfant : nouvelle session dont l'esclave est le terminal de contrôle.
+        // Seuls des appels async-signal-safe jusqu'à exec.
+        setsid();
+        ioctl(slaveFd, TIOCSCTTY, 0);
+        dup2(slaveFd, STDIN_FILENO);
+        dup2(slaveFd, STDOUT_FILENO);
+        dup2(slaveFd, STDERR_FILENO);
+        if (slaveFd > STDERR_FILENO) {
+            close(slaveFd);
+        }
+
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, nullptr);
+        for (int sig : kDefaultSignals) {
+            signal(sig, SIG_DFL);
+        }
+
+        int error = 0;
+        if (directory && chdir(directory) != 0) {
+            error = errno;
+        } else {
+            // execvp() cherche dans le PATH de Node et transmet environ
+            environ = envp;
+            execvp(argv[0], argv);
+            error = errno;
+        }
+        ssize_t ignored = write(status[1], &error, sizeof(error));
+        (void)ignored;
+        _exit(127);
+    }
+
+    close(status[1]);
+    int execError = 0;
+    ssize_t received;
+    do {
+        received = read(status[0], &execError, sizeof(execError));
+    } while (received < 0 && errno == EINTR);
+    close(status[0]);
+
+    if (received == static_cast<ssize_t>(sizeof(execError))) {
+        // exec a échoué : l'enfant est déjà sorti
+        while (waitpid(child, nullptr, 0) < 0 && errno == EINTR) {
+        }
+        return execError;
+    }
+
+    *result = child;
+    return 0;
+}
+
+bool UnixPTY::Start(const backend::SpawnOptions &options) {
+    if (!isInitialized || pid > 0) {
+        return false;
+    }
+    if (options.file.empty()) {
+        errno = EINVAL;
+        return false;
+    }
+
+    // argv et envp pointent dans options, sans recopie des chaînes
+    std::vector<char *> argv;
+    argv.reserve(options.args.size() + 2);
+    argv.push_back(const_cast<char *>(options.file.c_str()));
+    for (const std::string &arg : options.args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::vector<char *> envp;
+    char **env = environ;
+    if (!options.environment.empty()) {
+        const char *entry = options.environment.c_str();
+        const char *end = entry + options.environment.size();
+        while (entry < end && *entry) {
+            envp.push_back(const_cast<char *>(entry));
+            entry += strlen(entry) + 1;
+        }
+        envp.push_back(nullptr);
+        env = envp.data();
+    }
+
+    pid_t child = 0;
+    int error;
+#ifdef NEBULA_POSIX_SPAWN
+    char slaveName[128];
+    error = ttyname_r(slaveFd, slaveName, sizeof(slaveName));
+    if (error == 0) {
+        error = SpawnChild(slaveName, argv.data(), env, options.cwd, &child);
+    } else {
+        error = ForkChild(slaveFd, argv.data(), env, options.cwd, &child);
+    }
+#else
+    error = ForkChild(slaveFd, argv.data(), env, options.cwd, &child);
+#endif
+    if (error != 0) {
+        errno = error;
+        return false;
+    }
+
+    pid = child;
+    close(slaveFd);
+    slaveFd = -1;
+    return true;
+}
+
+bool UnixPTY::WaitFor(short events) {
+    struct pollfd fds[2];
+    fds[0].fd = masterFd;
+    fds[0].events = events;
+    fds[1].fd = wakeRead;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        fds[0].revents = fds[1].revents = 0;
+        int rc = poll(fds, 2, -1);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            // Le tube n'est pas vidé : l'annulation vaut pour toutes les attentes
+            errno = EAGAIN;
+            return false;
+        }
+
+        if (fds[0].revents & POLLNVAL) {
+            errno = EBADF;
+            return false;
+        }
+
+        // POLLHUP/POLLERR : le read()/write() suivant remontera l'erreur
+        if (fds[0].revents & (events | POLLHUP | POLLERR)) {
+            return true;
+        }
+    }
+}
+
+bool UnixPTY::TryWrite(const char *data, uint32_t length, uint32_t *written) {
+    *written = 0;
+    if (!isInitialized || masterFd < 0) {
+        errno = EBADF;
+        return false;
+    }
+
+    for (;;) {
+        ssize_t n = ::write(masterFd, data, length);
+        if (n >= 0) {
+            *written = static_cast<uint32_t>(n);
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool UnixPTY::Write(const char *data, uint32_t length, uint32_t *written) {
+    *written = 0;
+    if (!isInitialized || masterFd < 0) {
+        errno = EBADF;
+        return false;
+    }
+
+    while (*written < length) {
+        ssize_t n = ::write(masterFd, data + *written, length - *written);
+        if (n > 0) {
+            *written += static_cast<uint32_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Tampon d'entrée plein : on attend comme WriteFile le ferait
+            if (!WaitFor(POLLOUT)) {
+                return false;
+            }
+            continue;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool UnixPTY::TryRead(char *data, uint32_t length, uint32_t *read) {
+    *read = 0;
+    if (!isInitialized || masterFd < 0) {
+        errno = EBADF;
+        return false;
+    }
+
+    for (;;) {
+        ssize_t n = ::read(masterFd, data, length);
+        if (n > 0) {
+            *read = static_cast<uint32_t>(n);
+            return true;
+        }
+        if (n == 0) {
+            errno = EIO;
+            return false;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool UnixPTY::Read(char *data, uint32_t length, uint32_t *read) {
+    for (;;) {
+        if (TryRead(data, length, read)) {
+            return true;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return false;
+        }
+
+        // Rien à lire : on dort dans poll() jusqu'à ce que le maître soit lisible
+        if (!WaitFor(POLLIN)) {
+            return false;
+        }
+    }
+}
+
+uint32_t UnixPTY::BytesAvailable() {
+    if (!isInitialized || masterFd < 0) {
+        return 0;
+    }
+
+    int available = 0;
+    if (ioctl(masterFd, FIONREAD, &available) != 0 || available < 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>(available);
+}
+
+bool UnixPTY::Resize(int16_t cols, int16_t rows) {
+    if (!isInitialized) return false;
+
+    struct winsize size = {};
+    size.ws_col = static_cast<unsigned short>(cols);
+    size.ws_row = static_cast<unsigned short>(rows);
+    return ioctl(masterFd, TIOCSWINSZ, &size) == 0;
+}
+
+bool UnixPTY::Reap(bool wait) {
+    std::lock_guard<std::mutex> lock(reapMutex);
+    if (pid <= 0) {
+        return false;
+    }
+    if (exited) {
+        return true;
+    }
+
+    int status = 0;
+    pid_t rc;
+    do {
+        rc = waitpid(pid, &status, wait ? 0 : WNOHANG);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc == pid) {
+        if (WIFSIGNALED(status)) {
+            exitCode = 0;
+            exitSignal = WTERMSIG(status);
+        } else {
+            exitCode = WEXITSTATUS(status);
+            exitSignal = 0;
+        }
+        exited = true;
+    } else if (rc < 0 && errno == ECHILD) {
+        // Récolté hors d'ici : statut inconnu
+        exitCode = -1;
+        exitSignal = 0;
+        exited = true;
+    }
+    return exited;
+}
+
+bool UnixPTY::HasExited() {
+    return Reap(false);
+}
+
+bool UnixPTY::WatchExit(backend::ExitListener *listener) {
+    if (pid <= 0 || exitListener) {
+        return false;
+    }
+    if (exited) {
+        // Récolté pendant qu'il changeait de terminal : plus rien à surveiller
+        listener->OnProcessExit(exitCode, exitSignal);
+        return true;
+    }
+    exitListener = listener;
+    if (!ExitMonitor::Instance().Watch(pid, this)) {
+        exitListener = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void UnixPTY::UnwatchExit() {
+    if (exitListener) {
+        ExitMonitor::Instance().Unwatch(this);
+        exitListener = nullptr;
+    }
+}
+
+void UnixPTY::OnChildExit() {
+    // Le processus est terminé : waitpid() rend la main tout de suite
+    Reap(true);
+    exitListener->OnProcessExit(exitCode, exitSignal);
+}
+
+void UnixPTY::CancelIo() {
+    if (wakeWrite >= 0) {
+        char byte = 1;
+        ssize_t ignored = ::write(wakeWrite, &byte, 1);
+        (void)ignored;
+    }
+}
+
+void UnixPTY::ResumeIo() {
+    // Vide le réveil laissé par CancelIo() (descripteur non bloquant)
+    char buffer[64];
+    while (wakeRead >= 0 && ::read(wakeRead, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+void UnixPTY::Close() {
+    if (masterFd >= 0) {
+        close(masterFd);
+        masterFd = -1;
+    }
+
+    if (slaveFd >= 0) {
+        close(slaveFd);
+        slaveFd = -1;
+    }
+
+    UnwatchExit();
+    if (pid > 0) {
+        if (!Reap(false)) {
+            // Fermer le maître a déjà envoyé SIGHUP à la session ; le
+            // processus a un court délai pour finir avant SIGKILL
+            Reaper::Instance().Terminate(pid);
+        }
+        pid = 0;
+    }
+
+    if (wakeRead >= 0) {
+        close(wakeRead);
+        wakeRead = -1;
+    }
+
+    if (wakeWrite >= 0) {
+        close(wakeWrite);
+        wakeWrite = -1;
+    }
+
+    exited = false;
+    isInitialized = false;
+}
+
+} // namespace unixpty
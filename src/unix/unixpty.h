@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pty_backend.h"
+#include "unix/exit_monitor.h"
+#include <atomic>
+#include <mutex>
+#include <sys/types.h>
+#include <string>
+
+namespace unixpty {
+
+class UnixPTY : public backend::PtyBackend, private ExitWatcher {
+public:
+    UnixPTY();
+    ~UnixPTY();
+
+    bool Create(int16_t cols, int16_t rows) override;
+    bool Start(const backend::SpawnOptions &options) override;
+    bool Write(const char *data, uint32_t length, uint32_t *written) override;
+    bool TryWrite(const char *data, uint32_t length, uint32_t *written) override;
+    bool Read(char *data, uint32_t length, uint32_t *read) override;
+    bool TryRead(char *data, uint32_t length, uint32_t *read) override;
+    bool Resize(int16_t cols, int16_t rows) override;
+    void Close() override;
+    bool IsActive() const override;
+    bool HasExited() override;
+    uint32_t GetProcessId() const override { return static_cast<uint32_t>(pid); }
+    uint32_t BytesAvailable() override;
+    void CancelIo() override;
+    void ResumeIo() override;
+    int PollFd() const override { return masterFd; }
+    bool WatchExit(backend::ExitListener *listener) override;
+    void UnwatchExit() override;
+
+private:
+    bool CreateWakePipe();
+    bool WaitFor(short events);
+    bool Reap(bool wait);
+    void OnChildExit() override;
+
+    int masterFd;
+    int slaveFd;
+    int wakeRead;
+    int wakeWrite;
+    pid_t pid;
+    // waitpid() peut venir du moniteur de fin comme de HasExited()
+    std::mutex reapMutex;
+    std::atomic<bool> exited;
+    int exitCode;
+    int exitSignal;
+    backend::ExitListener *exitListener;
+    bool isInitialized;
+};
+
+} // namespace unixpty
@@ -0,0 +1,59 @@
+#include "vt/emulator.h"
+
+namespace vt {
+
+Emulator::Emulator(int cols, int rows) : screen(cols, rows), parser(screen) {
+}
+
+void Emulator::Feed(const char *data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    parser.Feed(data, length);
+}
+
+void Emulator::Resize(int cols, int rows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    screen.Resize(cols, rows);
+}
+
+std::string Emulator::Export() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out;
+    screen.Encode(&out);
+    return out;
+}
+
+std::string Emulator::ExportAnsi() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return screen.RenderAnsi();
+}
+
+bool Emulator::Import(const char *data, size_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!screen.Decode(data, length)) {
+        return false;
+    }
+    // Une séquence à moitié décodée n'a plus de sens sur le nouvel écran
+    parser.Reset();
+    return true;
+}
+
+bool Emulator::TakeFrame(std::string *out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!screen.HasDamage()) {
+        return false;
+    }
+    screen.EncodeFrame(out);
+    return true;
+}
+
+void Emulator::RequestFullFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    screen.DamageAll();
+}
+
+bool Emulator::BracketedPaste() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return screen.BracketedPaste();
+}
+
+} // namespace vt
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include "vt/parser.h"
+#include "vt/screen.h"
+
+namespace vt {
+
+// État d'écran d'un terminal : alimenté par le thread de lecture,
+// consulté depuis JS. Toutes les opérations prennent le verrou.
+class Emulator {
+public:
+    Emulator(int cols, int rows);
+
+    void Feed(const char *data, size_t length);
+    void Resize(int cols, int rows);
+
+    std::string Export();
+    std::string ExportAnsi();
+    bool Import(const char *data, size_t length);
+
+    // Trame des lignes modifiées depuis la précédente, false si rien n'a changé
+    bool TakeFrame(std::string *out);
+    void RequestFullFrame();
+
+    // Mode 2004 demandé par l'application (paste() encadre alors le collage)
+    bool BracketedPaste();
+
+private:
+    Emulator(const Emulator &) = delete;
+    Emulator &operator=(const Emulator &) = delete;
+
+    std::mutex mutex;
+    Screen screen;
+    Parser parser;
+};
+
+} // namespace vt
@@ -0,0 +1,81 @@
+#include "vt/framing.h"
+#include "vt/scan.h"
+
+namespace vt {
+
+// seq commence par ESC et ne contient pas d'autre ESC
+static bool EscapeComplete(const unsigned char *seq, size_t length) {
+    if (length < 2) {
+        return false;
+    }
+
+    unsigned char kind = seq[1];
+    if (kind == '[') {
+        // Paramètres et intermédiaires jusqu'à l'octet final 0x40-0x7E
+        for (size_t i = 2; i < length; i++) {
+            if (seq[i] >= 0x40) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (kind == ']') {
+        // OSC terminé par BEL ; la forme ESC \\ serait un ESC plus loin
+        for (size_t i = 2; i < length; i++) {
+            if (seq[i] == 0x07) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (kind == 'P' || kind == 'X' || kind == '^' || kind == '_') {
+        return false;
+    }
+    if (kind >= 0x20 && kind < 0x30) {
+        // ESC ( B et autres : intermédiaires puis un octet final
+        for (size_t i = 2; i < length; i++) {
+            if (seq[i] >= 0x30) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+static size_t IncompleteUtf8(const unsigned char *data, size_t length) {
+    size_t continuation = 0;
+    while (continuation < 3 && continuation < length && (data[length - 1 - continuation] & 0xC0) == 0x80) {
+        continuation++;
+    }
+    if (continuation == length) {
+        return 0;
+    }
+
+    unsigned char lead = data[length - 1 - continuation];
+    size_t need;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        need = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        need = 3;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        need = 4;
+    } else {
+        return 0;
+    }
+    return continuation + 1 < need ? continuation + 1 : 0;
+}
+
+size_t IncompleteTail(const char *data, size_t length) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    size_t window = length < kMaxHeldTail ? length : kMaxHeldTail;
+    size_t start = length - window;
+
+    size_t escape = FindLast(data + start, window, '\x1b');
+    if (escape < window && !EscapeComplete(bytes + start + escape, window - escape)) {
+        return window - escape;
+    }
+    return IncompleteUtf8(bytes, length);
+}
+
+} // namespace vt
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+namespace vt {
+
+// Au-delà, une séquence inachevée part telle quelle plutôt que d'être retenue
+static const size_t kMaxHeldTail = 4096;
+
+// Nombre d'octets en fin de data qui forment un caractère UTF-8 ou une
+// séquence d'échappement (CSI, OSC, DCS...) encore incomplets. Ces octets
+// sont gardés pour la livraison suivante afin que chaque morceau envoyé à
+// JS se termine sur une frontière.
+size_t IncompleteTail(const char *data, size_t length);
+
+} // namespace vt
@@ -0,0 +1,461 @@
+#include "vt/parser.h"
+#include "vt/scan.h"
+#include "vt/screen.h"
+#include <algorithm>
+
+namespace vt {
+
+static const uint32_t kReplacementChar = 0xFFFD;
+
+Parser::Parser(Screen &screen) : screen(screen) {
+    Reset();
+}
+
+void Parser::Reset() {
+    state = State::Ground;
+    codepoint = 0;
+    utf8Remaining = 0;
+    osc.clear();
+    ClearSequence();
+}
+
+void Parser::ClearSequence() {
+    std::fill(params, params + kMaxParams, 0);
+    paramCount = 0;
+    privateMarker = 0;
+    intermediate = 0;
+}
+
+int Parser::Param(int index, int defaultValue) const {
+    if (index >= paramCount || params[index] == 0) {
+        return defaultValue;
+    }
+    return params[index];
+}
+
+void Parser::Feed(const char *data, size_t length) {
+    const char *end = data + length;
+    while (data < end) {
+        if (state == State::Ground && utf8Remaining == 0) {
+            // Chemin rapide : texte ASCII jusqu'au prochain octet de contrôle
+            size_t run = PrintableRun(data, static_cast<size_t>(end - data));
+            if (run > 0) {
+                screen.PrintAscii(data, run);
+                data += run;
+                continue;
+            }
+        }
+        Step(static_cast<unsigned char>(*data++));
+    }
+}
+
+void Parser::Step(unsigned char byte) {
+    if (utf8Remaining > 0) {
+        if ((byte & 0xC0) == 0x80) {
+            codepoint = (codepoint << 6) | (byte & 0x3F);
+            if (--utf8Remaining == 0) {
+                bool valid = codepoint >= 0x80 && codepoint <= 0x10FFFF &&
+                             !(codepoint >= 0xD800 && codepoint <= 0xDFFF);
+                screen.Print(valid ? codepoint : kReplacementChar);
+            }
+            return;
+        }
+        // Séquence interrompue : le caractère incomplet est remplacé
+        utf8Remaining = 0;
+        screen.Print(kReplacementChar);
+    }
+
+    // Valables dans tous les états
+    if (byte == 0x18 || byte == 0x1A) {
+        state = State::Ground;
+        return;
+    }
+    if (byte == 0x1B) {
+        if (state == State::OscString) {
+            OscDispatch();
+        }
+        ClearSequence();
+        state = State::Escape;
+        return;
+    }
+
+    switch (state) {
+    case State::Ground:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte < 0x7F) {
+            screen.Print(byte);
+        } else if (byte >= 0xC2 && byte <= 0xDF) {
+            codepoint = byte & 0x1F;
+            utf8Remaining = 1;
+        } else if (byte >= 0xE0 && byte <= 0xEF) {
+            codepoint = byte & 0x0F;
+            utf8Remaining = 2;
+        } else if (byte >= 0xF0 && byte <= 0xF4) {
+            codepoint = byte & 0x07;
+            utf8Remaining = 3;
+        } else if (byte != 0x7F) {
+            screen.Print(kReplacementChar);
+        }
+        break;
+
+    case State::Escape:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte < 0x30) {
+            intermediate = static_cast<char>(byte);
+            state = State::EscapeIntermediate;
+        } else if (byte == '[') {
+            state = State::CsiEntry;
+        } else if (byte == ']') {
+            osc.clear();
+            state = State::OscString;
+        } else if (byte == 'P' || byte == 'X' || byte == '^' || byte == '_') {
+            state = State::StringIgnore;
+        } else if (byte < 0x7F) {
+            EscDispatch(byte);
+            state = State::Ground;
+        }
+        break;
+
+    case State::EscapeIntermediate:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte < 0x30) {
+            intermediate = static_cast<char>(byte);
+        } else if (byte < 0x7F) {
+            EscDispatch(byte);
+            state = State::Ground;
+        }
+        break;
+
+    case State::CsiEntry:
+    case State::CsiParam:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte >= '0' && byte <= '9') {
+            if (paramCount == 0) {
+                paramCount = 1;
+            }
+            int &param = params[paramCount - 1];
+            param = std::min(param * 10 + (byte - '0'), 65535);
+            state = State::CsiParam;
+        } else if (byte == ';' || byte == ':') {
+            // Les sous-paramètres (38:2:...) sont traités comme des paramètres
+            if (paramCount == 0) {
+                paramCount = 1;
+            }
+            if (paramCount < kMaxParams) {
+                paramCount++;
+            }
+            state = State::CsiParam;
+        } else if (byte >= 0x3C && byte <= 0x3F) {
+            if (state == State::CsiEntry) {
+                privateMarker = static_cast<char>(byte);
+                state = State::CsiParam;
+            } else {
+                state = State::CsiIgnore;
+            }
+        } else if (byte < 0x30) {
+            intermediate = static_cast<char>(byte);
+            state = State::CsiIntermediate;
+        } else if (byte < 0x7F) {
+            CsiDispatch(byte);
+            state = State::Ground;
+        }
+        break;
+
+    case State::CsiIntermediate:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte < 0x30) {
+            intermediate = static_cast<char>(byte);
+        } else if (byte < 0x40) {
+            state = State::CsiIgnore;
+        } else if (byte < 0x7F) {
+            CsiDispatch(byte);
+            state = State::Ground;
+        }
+        break;
+
+    case State::CsiIgnore:
+        if (byte < 0x20) {
+            Execute(byte);
+        } else if (byte >= 0x40 && byte < 0x7F) {
+            state = State::Ground;
+        }
+        break;
+
+    case State::OscString:
+        if (byte == 0x07) {
+            OscDispatch();
+            state = State::Ground;
+        } else if (byte >= 0x20 && osc.size() < kMaxOscLength) {
+            osc.push_back(static_cast<char>(byte));
+        }
+        break;
+
+    case State::StringIgnore:
+        break;
+    }
+}
+
+void Parser::Execute(unsigned char byte) {
+    switch (byte) {
+    case 0x08:
+        screen.Backspace();
+        break;
+    case 0x09:
+        screen.Tab();
+        break;
+    case 0x0A:
+    case 0x0B:
+    case 0x0C:
+        screen.Index();
+        break;
+    case 0x0D:
+        screen.CarriageReturn();
+        break;
+    default:
+        // BEL, SO/SI et autres : sans effet sur la grille
+        break;
+    }
+}
+
+void Parser::EscDispatch(unsigned char final) {
+    if (intermediate != 0) {
+        // Jeux de caractères (ESC ( B...) et DECALN : ignorés
+        return;
+    }
+
+    switch (final) {
+    case '7':
+        screen.SaveCursor();
+        break;
+    case '8':
+        screen.RestoreCursor();
+        break;
+    case 'D':
+        screen.Index();
+        break;
+    case 'E':
+        screen.CarriageReturn();
+        screen.Index();
+        break;
+    case 'M':
+        screen.ReverseIndex();
+        break;
+    case 'c':
+        screen.Reset();
+        Reset();
+        break;
+    default:
+        break;
+    }
+}
+
+void Parser::CsiDispatch(unsigned char final) {
+    if (privateMarker == '?') {
+        if (final == 'h' || final == 'l') {
+            SetModes(final == 'h');
+        }
+        return;
+    }
+    if (privateMarker != 0 || intermediate != 0) {
+        return;
+    }
+
+    int count = Param(0, 1);
+    switch (final) {
+    case '@':
+        screen.InsertChars(count);
+        break;
+    case 'A':
+        screen.MoveBy(0, -count);
+        break;
+    case 'B':
+    case 'e':
+        screen.MoveBy(0, count);
+        break;
+    case 'C':
+    case 'a':
+        screen.MoveBy(count, 0);
+        break;
+    case 'D':
+        screen.MoveBy(-count, 0);
+        break;
+    case 'E':
+        screen.MoveBy(0, count);
+        screen.CarriageReturn();
+        break;
+    case 'F':
+        screen.MoveBy(0, -count);
+        screen.CarriageReturn();
+        break;
+    case 'G':
+    case '`':
+        screen.MoveTo(count - 1, screen.CursorY());
+        break;
+    case 'H':
+    case 'f':
+        screen.MoveTo(Param(1, 1) - 1, Param(0, 1) - 1);
+        break;
+    case 'J':
+        screen.EraseInDisplay(Param(0, 0));
+        break;
+    case 'K':
+        screen.EraseInLine(Param(0, 0));
+        break;
+    case 'L':
+        screen.InsertLines(count);
+        break;
+    case 'M':
+        screen.DeleteLines(count);
+        break;
+    case 'P':
+        screen.DeleteChars(count);
+        break;
+    case 'S':
+        screen.ScrollUp(count);
+        break;
+    case 'T':
+        screen.ScrollDown(count);
+        break;
+    case 'X':
+        screen.EraseChars(count);
+        break;
+    case 'd':
+        screen.MoveTo(screen.CursorX(), count - 1);
+        break;
+    case 'm':
+        SelectGraphicRendition();
+        break;
+    case 'r':
+        screen.SetScrollRegion(Param(0, 1) - 1, Param(1, screen.Rows()) - 1);
+        break;
+    case 's':
+        screen.SaveCursor();
+        break;
+    case 'u':
+        screen.RestoreCursor();
+        break;
+    default:
+        break;
+    }
+}
+
+void Parser::SetModes(bool enabled) {
+    for (int i = 0; i < std::max(paramCount, 1); i++) {
+        switch (params[i]) {
+        case 1:
+            screen.SetApplicationCursor(enabled);
+            break;
+        case 7:
+            screen.SetAutoWrap(enabled);
+            break;
+        case 25:
+            screen.SetCursorVisible(enabled);
+            break;
+        case 47:
+        case 1047:
+            screen.SetAlternateScreen(enabled, false);
+            break;
+        case 1049:
+            screen.SetAlternateScreen(enabled, true);
+            break;
+        case 2004:
+            screen.SetBracketedPaste(enabled);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void Parser::SelectGraphicRendition() {
+    Attributes &pen = screen.Pen();
+    int count = std::max(paramCount, 1);
+
+    for (int i = 0; i < count; i++) {
+        int value = params[i];
+        if (value == 0) {
+            pen = Attributes{kDefaultColor, kDefaultColor, 0};
+        } else if (value == 1) {
+            pen.flags |= kBold;
+        } else if (value == 2) {
+            pen.flags |= kDim;
+        } else if (value == 3) {
+            pen.flags |= kItalic;
+        } else if (value == 4) {
+            pen.flags |= kUnderline;
+        } else if (value == 5) {
+            pen.flags |= kBlink;
+        } else if (value == 7) {
+            pen.flags |= kInverse;
+        } else if (value == 8) {
+            pen.flags |= kHidden;
+        } else if (value == 9) {
+            pen.flags |= kStrike;
+        } else if (value == 22) {
+            pen.flags &= ~(kBold | kDim);
+        } else if (value == 23) {
+            pen.flags &= ~kItalic;
+        } else if (value == 24) {
+            pen.flags &= ~kUnderline;
+        } else if (value == 25) {
+            pen.flags &= ~kBlink;
+        } else if (value == 27) {
+            pen.flags &= ~kInverse;
+        } else if (value == 28) {
+            pen.flags &= ~kHidden;
+        } else if (value == 29) {
+            pen.flags &= ~kStrike;
+        } else if (value >= 30 && value <= 37) {
+            pen.fg = kPaletteColor | static_cast<uint32_t>(value - 30);
+        } else if (value == 39) {
+            pen.fg = kDefaultColor;
+        } else if (value >= 40 && value <= 47) {
+            pen.bg = kPaletteColor | static_cast<uint32_t>(value - 40);
+        } else if (value == 49) {
+            pen.bg = kDefaultColor;
+        } else if (value >= 90 && value <= 97) {
+            pen.fg = kPaletteColor | static_cast<uint32_t>(value - 90 + 8);
+        } else if (value >= 100 && value <= 107) {
+            pen.bg = kPaletteColor | static_cast<uint32_t>(value - 100 + 8);
+        } else if (value == 38 || value == 48) {
+            // 38;5;n (palette) ou 38;2;r;g;b (couleur directe)
+            uint32_t color = kDefaultColor;
+            if (i + 2 < count && params[i + 1] == 5) {
+                color = kPaletteColor | static_cast<uint32_t>(params[i + 2] & 0xFF);
+                i += 2;
+            } else if (i + 4 < count && params[i + 1] == 2) {
+                color = kRgbColor |
+                        (static_cast<uint32_t>(params[i + 2] & 0xFF) << 16) |
+                        (static_cast<uint32_t>(params[i + 3] & 0xFF) << 8) |
+                        static_cast<uint32_t>(params[i + 4] & 0xFF);
+                i += 4;
+            } else {
+                break;
+            }
+            if (value == 38) {
+                pen.fg = color;
+            } else {
+                pen.bg = color;
+            }
+        }
+    }
+}
+
+void Parser::OscDispatch() {
+    // OSC 0 et 2 : titre de la fenêtre
+    size_t separator = osc.find(';');
+    if (separator != std::string::npos) {
+        std::string command = osc.substr(0, separator);
+        if (command == "0" || command == "2") {
+            screen.SetTitle(osc.substr(separator + 1));
+        }
+    }
+    osc.clear();
+}
+
+} // namespace vt
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vt {
+
+class Screen;
+
+// Décodeur VT/ANSI (machine d'états de type DEC) qui pilote un vt::Screen.
+// Les séquences et caractères UTF-8 coupés entre deux appels à Feed() sont
+// repris au suivant. Les longues suites d'ASCII imprimable sont copiées
+// d'un bloc dans la grille.
+class Parser {
+public:
+    explicit Parser(Screen &screen);
+
+    void Feed(const char *data, size_t length);
+    void Reset();
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        EscapeIntermediate,
+        CsiEntry,
+        CsiParam,
+        CsiIntermediate,
+        CsiIgnore,
+        OscString,
+        StringIgnore,
+    };
+
+    static const int kMaxParams = 16;
+    static const size_t kMaxOscLength = 4096;
+
+    void Step(unsigned char byte);
+    void Execute(unsigned char byte);
+    void EscDispatch(unsigned char final);
+    void CsiDispatch(unsigned char final);
+    void OscDispatch();
+    void SetModes(bool enabled);
+    void SelectGraphicRendition();
+    void ClearSequence();
+    int Param(int index, int defaultValue) const;
+
+    Screen &screen;
+    State state;
+
+    int params[kMaxParams];
+    int paramCount;
+    char privateMarker;
+    char intermediate;
+    std::string osc;
+
+    // Caractère UTF-8 en cours de décodage
+    uint32_t codepoint;
+    int utf8Remaining;
+};
+
+} // namespace vt
@@ -0,0 +1,269 @@
+#include "vt/scan.h"
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define VT_SCAN_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VT_SCAN_NEON 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace vt {
+
+#ifdef VT_SCAN_SSE2
+static inline unsigned LowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+#ifdef VT_SCAN_SSE2
+static inline unsigned HighestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return 31u - static_cast<unsigned>(__builtin_clz(mask));
+#endif
+}
+#endif
+
+static inline bool IsPrintable(unsigned char byte) {
+    return byte >= 0x20 && byte < 0x7F;
+}
+
+size_t PrintableRun(const char *data, size_t length) {
+    size_t i = 0;
+
+#if defined(VT_SCAN_SSE2)
+    // Comparaison signée : les octets >= 0x80 sont négatifs et donc exclus
+    const __m128i space = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, del), _mm_cmpgt_epi8(bytes, space));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(printable));
+        if (mask != 0xFFFF) {
+            return i + LowestBit(~mask & 0xFFFF);
+        }
+    }
+#elif defined(VT_SCAN_NEON)
+    const uint8x16_t space = vdupq_n_u8(0x1F);
+    const uint8x16_t del = vdupq_n_u8(0x7F);
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
+        uint8x16_t printable = vandq_u8(vcgtq_u8(bytes, space), vcltq_u8(bytes, del));
+        if (vminvq_u8(printable) != 0xFF) {
+            break;
+        }
+    }
+#endif
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    while (i < length && IsPrintable(bytes[i])) {
+        i++;
+    }
+    return i;
+}
+
+size_t AsciiRun(const char *data, size_t length) {
+    size_t i = 0;
+
+#if defined(VT_SCAN_SSE2)
+    // Le bit de poids fort de chaque octet, 64 octets par tour
+    for (; i + 64 <= length; i += 64) {
+        const __m128i *p = reinterpret_cast<const __m128i *>(data + i);
+        __m128i any = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+                                   _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+        if (_mm_movemask_epi8(any) != 0) {
+            break;
+        }
+    }
+    for (; i + 16 <= length; i += 16) {
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))));
+        if (mask != 0) {
+            return i + LowestBit(mask);
+        }
+    }
+#elif defined(VT_SCAN_NEON)
+    for (; i + 16 <= length; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(data + i))) >= 0x80) {
+            break;
+        }
+    }
+#endif
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    while (i < length && bytes[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+size_t FindLast(const char *data, size_t length, char byte) {
+    size_t i = length;
+
+#if defined(VT_SCAN_SSE2)
+    const __m128i needle = _mm_set1_epi8(byte);
+    for (; i >= 16; i -= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i - 16));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)));
+        if (mask != 0) {
+            return i - 16 + HighestBit(mask);
+        }
+    }
+#elif defined(VT_SCAN_NEON)
+    const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(byte));
+    for (; i >= 16; i -= 16) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i - 16));
+        if (vmaxvq_u8(vceqq_u8(bytes, needle)) != 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i > 0) {
+        if (data[--i] == byte) {
+            return i;
+        }
+    }
+    return length;
+}
+
+ByteSet::ByteSet() : lowNibbles(), member(), values(), count(0) {
+}
+
+void ByteSet::Add(unsigned char byte) {
+    if (member[byte]) {
+        return;
+    }
+    member[byte] = true;
+    lowNibbles[byte >> 7][byte & 0x0F] |= static_cast<uint8_t>(1u << ((byte >> 4) & 7));
+    if (count < kMaxCompared) {
+        values[count] = byte;
+    }
+    count++;
+}
+
+#if defined(VT_SCAN_SSE2)
+// pshufb n'est pas garanti par SSE2 : choisi à l'exécution
+static bool DetectSsse3() {
+#if defined(__SSSE3__)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static const bool kHasSsse3 = DetectSsse3();
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VT_TARGET_SSSE3
+#else
+#define VT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+// Renvoie la position du premier octet de set, ou le début de la fin de
+// data (moins de 16 octets) laissée au repli scalaire
+VT_TARGET_SSSE3 static size_t FindAnyOfSsse3(const char *data, size_t length, const uint8_t (*lowNibbles)[16]) {
+    const __m128i low0 = _mm_load_si128(reinterpret_cast<const __m128i *>(lowNibbles[0]));
+    const __m128i low1 = _mm_load_si128(reinterpret_cast<const __m128i *>(lowNibbles[1]));
+    // Bit attendu pour chaque quartet haut, dans la table 0-7 ou 8-15
+    const __m128i high0 = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i high1 = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i low = _mm_and_si128(bytes, nibble);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        __m128i hit = _mm_or_si128(
+            _mm_and_si128(_mm_shuffle_epi8(low0, low), _mm_shuffle_epi8(high0, high)),
+            _mm_and_si128(_mm_shuffle_epi8(low1, low), _mm_shuffle_epi8(high1, high)));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(hit, zero))) & 0xFFFFu;
+        if (mask != 0) {
+            return i + LowestBit(mask);
+        }
+    }
+    return i;
+}
+#endif
+
+size_t FindAnyOf(const char *data, size_t length, const ByteSet &set) {
+    size_t i = 0;
+
+#if defined(VT_SCAN_SSE2)
+    if (kHasSsse3) {
+        i = FindAnyOfSsse3(data, length, set.lowNibbles);
+    } else if (set.count <= ByteSet::kMaxCompared) {
+        __m128i needles[ByteSet::kMaxCompared];
+        for (size_t n = 0; n < set.count; n++) {
+            needles[n] = _mm_set1_epi8(static_cast<char>(set.values[n]));
+        }
+        for (; i + 16 <= length; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i hit = _mm_setzero_si128();
+            for (size_t n = 0; n < set.count; n++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(bytes, needles[n]));
+            }
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+            if (mask != 0) {
+                return i + LowestBit(mask);
+            }
+        }
+    }
+#elif defined(VT_SCAN_NEON)
+    {
+        const uint8x16_t low0 = vld1q_u8(set.lowNibbles[0]);
+        const uint8x16_t low1 = vld1q_u8(set.lowNibbles[1]);
+        static const uint8_t kHigh[2][16] = {
+            {1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0},
+            {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64, 128},
+        };
+        const uint8x16_t high0 = vld1q_u8(kHigh[0]);
+        const uint8x16_t high1 = vld1q_u8(kHigh[1]);
+        const uint8x16_t nibble = vdupq_n_u8(0x0F);
+        for (; i + 16 <= length; i += 16) {
+            uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
+            uint8x16_t low = vandq_u8(bytes, nibble);
+            uint8x16_t high = vshrq_n_u8(bytes, 4);
+            uint8x16_t hit = vorrq_u8(vandq_u8(vqtbl1q_u8(low0, low), vqtbl1q_u8(high0, high)),
+                                      vandq_u8(vqtbl1q_u8(low1, low), vqtbl1q_u8(high1, high)));
+            if (vmaxvq_u8(hit) != 0) {
+                // La position exacte est trouvée par le repli scalaire
+                break;
+            }
+        }
+    }
+#endif
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    for (; i < length; i++) {
+        if (set.member[bytes[i]]) {
+            return i;
+        }
+    }
+    return length;
+}
+
+} // namespace vt
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace vt {
+
+// Longueur du préfixe d'ASCII imprimable (0x20-0x7E). SSE2 ou NEON quand
+// disponible, 16 octets par itération ; repli scalaire sinon.
+size_t PrintableRun(const char *data, size_t length);
+
+// Longueur du préfixe ASCII (octets < 0x80), même principe
+size_t AsciiRun(const char *data, size_t length);
+
+// Position de la dernière occurrence de byte, length si absent
+size_t FindLast(const char *data, size_t length, char byte);
+
+// Ensemble d'octets de taille quelconque pour FindAnyOf(), préparé une
+// fois : tables de quartets pour pshufb (SSSE3) ou tbl (NEON), table
+// complète pour le repli scalaire.
+class ByteSet {
+public:
+    ByteSet();
+
+    void Add(unsigned char byte);
+    bool Contains(unsigned char byte) const { return member[byte]; }
+    size_t Size() const { return count; }
+
+private:
+    friend size_t FindAnyOf(const char *data, size_t length, const ByteSet &set);
+
+    // Petits ensembles sans SSSE3 : une comparaison SSE2 par valeur
+    static const size_t kMaxCompared = 8;
+
+    // Bit (quartet haut % 8) de l'entrée (quartet bas), pour les quartets
+    // hauts 0-7 puis 8-15 : l'appartenance est exacte, sans faux positif
+    alignas(16) uint8_t lowNibbles[2][16];
+    bool member[256];
+    unsigned char values[kMaxCompared];
+    size_t count;
+};
+
+// Position du premier octet présent dans set, length si absent : préfiltre
+// des déclencheurs. 16 octets par itération quel que soit l'ensemble.
+size_t FindAnyOf(const char *data, size_t length, const ByteSet &set);
+
+} // namespace vt
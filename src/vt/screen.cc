@@ -0,0 +1,387 @@
+#include "vt/screen.h"
+#include <algorithm>
+
+namespace vt {
+
+static const Attributes kDefaultAttributes = {kDefaultColor, kDefaultColor, 0};
+
+// Largeur d'affichage approchée : combinants ignorés, CJK et emoji sur
+// deux colonnes. Suffit pour garder le curseur aligné avec les shells.
+static int CharWidth(uint32_t codepoint) {
+    if ((codepoint >= 0x0300 && codepoint <= 0x036F) ||
+        (codepoint >= 0x200B && codepoint <= 0x200F) ||
+        (codepoint >= 0xFE00 && codepoint <= 0xFE0F)) {
+        return 0;
+    }
+    if ((codepoint >= 0x1100 && codepoint <= 0x115F) ||
+        (codepoint >= 0x2E80 && codepoint <= 0xA4CF && codepoint != 0x303F) ||
+        (codepoint >= 0xAC00 && codepoint <= 0xD7A3) ||
+        (codepoint >= 0xF900 && codepoint <= 0xFAFF) ||
+        (codepoint >= 0xFE30 && codepoint <= 0xFE4F) ||
+        (codepoint >= 0xFF00 && codepoint <= 0xFF60) ||
+        (codepoint >= 0xFFE0 && codepoint <= 0xFFE6) ||
+        (codepoint >= 0x1F300 && codepoint <= 0x1F64F) ||
+        (codepoint >= 0x1F900 && codepoint <= 0x1F9FF) ||
+        (codepoint >= 0x20000 && codepoint <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+Screen::Screen(int cols, int rows)
+    : cols(0), rows(0), alternate(false), cursor{0, 0, kDefaultAttributes, false},
+      damaged(false), fullDamage(false), frameX(-1), frameY(-1), frameCursorVisible(false) {
+    for (Buffer &buffer : buffers) {
+        buffer.saved = SavedCursor{0, 0, kDefaultAttributes};
+    }
+    Resize(cols, rows);
+    Reset();
+}
+
+Cell Screen::Blank() const {
+    // Effacement avec la couleur de fond courante (BCE), comme xterm
+    Cell cell = {' ', kDefaultAttributes};
+    cell.attr.bg = cursor.attr.bg;
+    return cell;
+}
+
+void Screen::Reset() {
+    cursor = Cursor{0, 0, kDefaultAttributes, false};
+    for (Buffer &buffer : buffers) {
+        for (Line &line : buffer.lines) {
+            std::fill(line.begin(), line.end(), Blank());
+        }
+        buffer.saved = SavedCursor{0, 0, kDefaultAttributes};
+    }
+    alternate = false;
+    scrollTop = 0;
+    scrollBottom = rows - 1;
+    cursorVisible = true;
+    autoWrap = true;
+    applicationCursor = false;
+    bracketedPaste = false;
+    title.clear();
+    DamageAll();
+}
+
+void Screen::Resize(int newCols, int newRows) {
+    newCols = std::max(1, newCols);
+    newRows = std::max(1, newRows);
+    if (static_cast<long long>(newCols) * newRows > kMaxCells) {
+        newRows = std::max(1, kMaxCells / newCols);
+    }
+
+    const Cell blank = {' ', kDefaultAttributes};
+    for (int i = 0; i < 2; i++) {
+        std::vector<Line> &lines = buffers[i].lines;
+        if (static_cast<int>(lines.size()) > newRows) {
+            // On garde la ligne du curseur visible en retirant par le haut
+            int excess = static_cast<int>(lines.size()) - newRows;
+            int fromTop = (i == (alternate ? 1 : 0)) ? std::min(excess, std::max(0, cursor.y - (newRows - 1))) : 0;
+            lines.erase(lines.begin(), lines.begin() + fromTop);
+            lines.resize(newRows);
+            if (i == (alternate ? 1 : 0)) {
+                cursor.y -= fromTop;
+            }
+        } else {
+            lines.resize(newRows, Line(newCols, blank));
+        }
+        for (Line &line : lines) {
+            line.resize(newCols, blank);
+        }
+        buffers[i].saved.x = std::min(buffers[i].saved.x, newCols - 1);
+        buffers[i].saved.y = std::min(buffers[i].saved.y, newRows - 1);
+    }
+
+    cols = newCols;
+    rows = newRows;
+    cursor.x = std::min(cursor.x, cols - 1);
+    cursor.y = std::min(cursor.y, rows - 1);
+    cursor.wrapPending = false;
+    scrollTop = 0;
+    scrollBottom = rows - 1;
+    damage.assign(rows, 1);
+    DamageAll();
+}
+
+void Screen::Wrap() {
+    cursor.wrapPending = false;
+    cursor.x = 0;
+    Index();
+}
+
+void Screen::Print(uint32_t codepoint) {
+    int width = CharWidth(codepoint);
+    if (width == 0) {
+        return;
+    }
+    if (cursor.wrapPending) {
+        Wrap();
+    }
+    if (width == 2 && cursor.x == cols - 1) {
+        if (!autoWrap || cols < 2) {
+            return;
+        }
+        ClearLine(cursor.y, cursor.x, cols);
+        Wrap();
+    }
+
+    Line &line = Active().lines[cursor.y];
+    line[cursor.x] = Cell{codepoint, cursor.attr};
+    Damage(cursor.y);
+    if (width == 2) {
+        line[cursor.x + 1] = Cell{0, cursor.attr};
+    }
+
+    if (cursor.x + width >= cols) {
+        cursor.x = cols - 1;
+        cursor.wrapPending = autoWrap;
+    } else {
+        cursor.x += width;
+    }
+}
+
+void Screen::PrintAscii(const char *data, size_t length) {
+    while (length > 0) {
+        if (cursor.wrapPending) {
+            Wrap();
+        }
+
+        Line &line = Active().lines[cursor.y];
+        size_t room = static_cast<size_t>(cols - cursor.x);
+        if (!autoWrap && length > room) {
+            // Sans retour automatique le surplus s'écrase sur la dernière colonne
+            data += length - room;
+            length = room;
+        }
+
+        size_t count = std::min(length, room);
+        Damage(cursor.y);
+        Cell *cell = &line[cursor.x];
+        for (size_t i = 0; i < count; i++) {
+            cell[i].codepoint = static_cast<unsigned char>(data[i]);
+            cell[i].attr = cursor.attr;
+        }
+        data += count;
+        length -= count;
+
+        if (count == room) {
+            cursor.x = cols - 1;
+            cursor.wrapPending = autoWrap;
+        } else {
+            cursor.x += static_cast<int>(count);
+        }
+    }
+}
+
+void Screen::CarriageReturn() {
+    cursor.x = 0;
+    cursor.wrapPending = false;
+}
+
+void Screen::Backspace() {
+    cursor.wrapPending = false;
+    if (cursor.x > 0) {
+        cursor.x--;
+    }
+}
+
+void Screen::Tab() {
+    cursor.wrapPending = false;
+    cursor.x = std::min(cols - 1, (cursor.x / 8 + 1) * 8);
+}
+
+void Screen::Index() {
+    if (cursor.y == scrollBottom) {
+        ScrollRegion(scrollTop, scrollBottom, 1);
+    } else if (cursor.y < rows - 1) {
+        cursor.y++;
+    }
+}
+
+void Screen::ReverseIndex() {
+    cursor.wrapPending = false;
+    if (cursor.y == scrollTop) {
+        ScrollRegion(scrollTop, scrollBottom, -1);
+    } else if (cursor.y > 0) {
+        cursor.y--;
+    }
+}
+
+void Screen::MoveTo(int x, int y) {
+    cursor.x = std::max(0, std::min(x, cols - 1));
+    cursor.y = std::max(0, std::min(y, rows - 1));
+    cursor.wrapPending = false;
+}
+
+void Screen::MoveBy(int dx, int dy) {
+    // Les déplacements verticaux restent dans la région de défilement
+    int y = cursor.y + dy;
+    if (cursor.y >= scrollTop && cursor.y <= scrollBottom) {
+        y = std::max(scrollTop, std::min(y, scrollBottom));
+    }
+    MoveTo(cursor.x + dx, y);
+}
+
+void Screen::ClearLine(int y, int from, int to) {
+    from = std::max(0, from);
+    to = std::min(cols, to);
+    if (from < to) {
+        Line &line = Active().lines[y];
+        std::fill(line.begin() + from, line.begin() + to, Blank());
+        Damage(y);
+    }
+}
+
+void Screen::Damage(int y) {
+    damage[y] = 1;
+    damaged = true;
+}
+
+void Screen::DamageAll() {
+    std::fill(damage.begin(), damage.end(), 1);
+    damaged = true;
+    fullDamage = true;
+}
+
+void Screen::EraseInDisplay(int mode) {
+    if (mode == 0) {
+        ClearLine(cursor.y, cursor.x, cols);
+        for (int y = cursor.y + 1; y < rows; y++) {
+            ClearLine(y, 0, cols);
+        }
+    } else if (mode == 1) {
+        for (int y = 0; y < cursor.y; y++) {
+            ClearLine(y, 0, cols);
+        }
+        ClearLine(cursor.y, 0, cursor.x + 1);
+    } else if (mode == 2 || mode == 3) {
+        for (int y = 0; y < rows; y++) {
+            ClearLine(y, 0, cols);
+        }
+    }
+}
+
+void Screen::EraseInLine(int mode) {
+    if (mode == 0) {
+        ClearLine(cursor.y, cursor.x, cols);
+    } else if (mode == 1) {
+        ClearLine(cursor.y, 0, cursor.x + 1);
+    } else if (mode == 2) {
+        ClearLine(cursor.y, 0, cols);
+    }
+}
+
+void Screen::EraseChars(int count) {
+    ClearLine(cursor.y, cursor.x, cursor.x + std::max(1, count));
+}
+
+void Screen::InsertChars(int count) {
+    Line &line = Active().lines[cursor.y];
+    count = std::min(std::max(1, count), cols - cursor.x);
+    std::copy_backward(line.begin() + cursor.x, line.end() - count, line.end());
+    ClearLine(cursor.y, cursor.x, cursor.x + count);
+    cursor.wrapPending = false;
+}
+
+void Screen::DeleteChars(int count) {
+    Line &line = Active().lines[cursor.y];
+    count = std::min(std::max(1, count), cols - cursor.x);
+    std::copy(line.begin() + cursor.x + count, line.end(), line.begin() + cursor.x);
+    ClearLine(cursor.y, cols - count, cols);
+    cursor.wrapPending = false;
+}
+
+void Screen::ScrollRegion(int top, int bottom, int count) {
+    // Rotation des lignes (échange de vecteurs), pas de copie de cellules
+    std::vector<Line> &lines = Active().lines;
+    int height = bottom - top + 1;
+    for (int y = top; y <= bottom; y++) {
+        Damage(y);
+    }
+    if (count > 0) {
+        count = std::min(count, height);
+        std::rotate(lines.begin() + top, lines.begin() + top + count, lines.begin() + bottom + 1);
+        for (int y = bottom - count + 1; y <= bottom; y++) {
+            ClearLine(y, 0, cols);
+        }
+    } else if (count < 0) {
+        count = std::min(-count, height);
+        std::rotate(lines.begin() + top, lines.begin() + bottom + 1 - count, lines.begin() + bottom + 1);
+        for (int y = top; y < top + count; y++) {
+            ClearLine(y, 0, cols);
+        }
+    }
+}
+
+void Screen::InsertLines(int count) {
+    if (cursor.y < scrollTop || cursor.y > scrollBottom) return;
+    ScrollRegion(cursor.y, scrollBottom, -std::max(1, count));
+    cursor.x = 0;
+    cursor.wrapPending = false;
+}
+
+void Screen::DeleteLines(int count) {
+    if (cursor.y < scrollTop || cursor.y > scrollBottom) return;
+    ScrollRegion(cursor.y, scrollBottom, std::max(1, count));
+    cursor.x = 0;
+    cursor.wrapPending = false;
+}
+
+void Screen::ScrollUp(int count) {
+    ScrollRegion(scrollTop, scrollBottom, std::max(1, count));
+}
+
+void Screen::ScrollDown(int count) {
+    ScrollRegion(scrollTop, scrollBottom, -std::max(1, count));
+}
+
+void Screen::SetScrollRegion(int top, int bottom) {
+    top = std::max(0, top);
+    bottom = std::min(rows - 1, bottom);
+    if (top >= bottom) return;
+
+    scrollTop = top;
+    scrollBottom = bottom;
+    MoveTo(0, 0);
+}
+
+void Screen::SaveCursor() {
+    Active().saved = SavedCursor{cursor.x, cursor.y, cursor.attr};
+}
+
+void Screen::RestoreCursor() {
+    const SavedCursor &saved = Active().saved;
+    cursor.attr = saved.attr;
+    MoveTo(saved.x, saved.y);
+}
+
+void Screen::SetAlternateScreen(bool enabled, bool saveCursor) {
+    if (enabled == alternate) return;
+
+    if (enabled) {
+        if (saveCursor) {
+            SaveCursor();
+        }
+        alternate = true;
+        for (int y = 0; y < rows; y++) {
+            ClearLine(y, 0, cols);
+        }
+    } else {
+        alternate = false;
+        if (saveCursor) {
+            RestoreCursor();
+        }
+    }
+    cursor.wrapPending = false;
+    DamageAll();
+}
+
+void Screen::SetAutoWrap(bool enabled) {
+    autoWrap = enabled;
+    if (!enabled) {
+        cursor.wrapPending = false;
+    }
+}
+
+} // namespace vt
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vt {
+
+// Couleur d'une cellule : 0 pour la couleur par défaut, sinon type dans
+// l'octet de poids fort et valeur (index de palette ou 0xRRGGBB) dessous.
+static const uint32_t kDefaultColor = 0;
+static const uint32_t kPaletteColor = 1u << 24;
+static const uint32_t kRgbColor = 2u << 24;
+
+enum CellFlags : uint16_t {
+    kBold = 1 << 0,
+    kDim = 1 << 1,
+    kItalic = 1 << 2,
+    kUnderline = 1 << 3,
+    kBlink = 1 << 4,
+    kInverse = 1 << 5,
+    kHidden = 1 << 6,
+    kStrike = 1 << 7,
+};
+
+struct Attributes {
+    uint32_t fg;
+    uint32_t bg;
+    uint16_t flags;
+
+    bool operator==(const Attributes &other) const {
+        return fg == other.fg && bg == other.bg && flags == other.flags;
+    }
+    bool operator!=(const Attributes &other) const { return !(*this == other); }
+};
+
+// codepoint 0 : seconde moitié d'un caractère double largeur
+struct Cell {
+    uint32_t codepoint;
+    Attributes attr;
+};
+
+struct SavedCursor {
+    int x;
+    int y;
+    Attributes attr;
+};
+
+// Grille de cellules d'un terminal sans affichage : écran principal et
+// alternatif, curseur, attributs courants et région de défilement. Les
+// séquences sont décodées par vt::Parser, qui appelle ces opérations.
+class Screen {
+public:
+    static const int kMaxCells = 1 << 22;
+
+    Screen(int cols, int rows);
+
+    int Cols() const { return cols; }
+    int Rows() const { return rows; }
+    void Resize(int cols, int rows);
+    void Reset();
+
+    // Texte
+    void Print(uint32_t codepoint);
+    void PrintAscii(const char *data, size_t length);
+
+    // Mouvements
+    void CarriageReturn();
+    void Backspace();
+    void Tab();
+    void Index();
+    void ReverseIndex();
+    void MoveTo(int x, int y);
+    void MoveBy(int dx, int dy);
+    int CursorX() const { return cursor.x; }
+    int CursorY() const { return cursor.y; }
+
+    // Effacement et édition
+    void EraseInDisplay(int mode);
+    void EraseInLine(int mode);
+    void EraseChars(int count);
+    void InsertChars(int count);
+    void DeleteChars(int count);
+    void InsertLines(int count);
+    void DeleteLines(int count);
+    void ScrollUp(int count);
+    void ScrollDown(int count);
+    void SetScrollRegion(int top, int bottom);
+
+    // État
+    Attributes &Pen() { return cursor.attr; }
+    void SaveCursor();
+    void RestoreCursor();
+    void SetAlternateScreen(bool enabled, bool saveCursor);
+    void SetCursorVisible(bool visible) { cursorVisible = visible; }
+    void SetAutoWrap(bool enabled);
+    void SetApplicationCursor(bool enabled) { applicationCursor = enabled; }
+    void SetBracketedPaste(bool enabled) { bracketedPaste = enabled; }
+    bool BracketedPaste() const { return bracketedPaste; }
+    void SetTitle(const std::string &value) { title = value; }
+
+    // Instantanés (snapshot.cc) : binaire compact, ou séquences ANSI qui
+    // redessinent l'écran chez un client xterm.
+    void Encode(std::string *out) const;
+    bool Decode(const char *data, size_t length);
+    std::string RenderAnsi() const;
+
+    // Suivi des lignes modifiées depuis la dernière trame. Ce qui a été
+    // réécrit plusieurs fois entre deux trames n'y figure qu'une fois.
+    bool HasDamage() const;
+    void DamageAll();
+    void EncodeFrame(std::string *out);
+
+private:
+    typedef std::vector<Cell> Line;
+
+    struct Buffer {
+        std::vector<Line> lines;
+        SavedCursor saved;
+    };
+
+    struct Cursor {
+        int x;
+        int y;
+        Attributes attr;
+        bool wrapPending;
+    };
+
+    Buffer &Active() { return buffers[alternate ? 1 : 0]; }
+    const Buffer &Active() const { return buffers[alternate ? 1 : 0]; }
+    Cell Blank() const;
+    void ClearLine(int y, int from, int to);
+    void Damage(int y);
+    void ScrollRegion(int top, int bottom, int count);
+    void Wrap();
+
+    int cols;
+    int rows;
+    Buffer buffers[2];
+    bool alternate;
+    Cursor cursor;
+    int scrollTop;
+    int scrollBottom;
+    bool cursorVisible;
+    bool autoWrap;
+    bool applicationCursor;
+    bool bracketedPaste;
+    std::string title;
+
+    // Dernière trame émise
+    std::vector<uint8_t> damage;
+    bool damaged;
+    bool fullDamage;
+    int frameX;
+    int frameY;
+    bool frameCursorVisible;
+};
+
+} // namespace vt
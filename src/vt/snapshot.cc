@@ -0,0 +1,355 @@
+#include "vt/screen.h"
+#include <cstring>
+
+namespace vt {
+
+// Instantané binaire (version 1), entiers en varint sauf mention :
+//   "NPSS", version (octet), cols, rows, drapeaux (octet)
+//   curseur x, y, attributs du stylo, région de défilement haut, bas
+//   titre (longueur + octets)
+//   pour chaque écran (principal puis alternatif) : curseur sauvegardé
+//   (x, y, attributs), puis pour chaque ligne le nombre de cellules
+//   utilisées et des plages (longueur, attributs, codepoints). Les
+//   cellules vides en fin de ligne ne sont pas stockées.
+//
+// Trame (version 1) : version (octet), drapeaux (octet), cols, rows,
+// curseur x, y, nombre de lignes, puis pour chacune son indice suivi du
+// même encodage de ligne. Avec kFullFrame, toutes les lignes sont
+// présentes et le client repart de zéro (redimensionnement, écran
+// alternatif, import).
+static const char kMagic[4] = {'N', 'P', 'S', 'S'};
+static const uint8_t kVersion = 1;
+
+enum SnapshotFlags : uint8_t {
+    kAlternate = 1 << 0,
+    kCursorVisible = 1 << 1,
+    kAutoWrap = 1 << 2,
+    kWrapPending = 1 << 3,
+    kApplicationCursor = 1 << 4,
+    kBracketedPaste = 1 << 5,
+};
+
+enum FrameFlags : uint8_t {
+    kFullFrame = 1 << 0,
+    kFrameCursorVisible = 1 << 1,
+    kFrameAlternate = 1 << 2,
+};
+
+static void PutVarint(std::string *out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+static void PutAttributes(std::string *out, const Attributes &attr) {
+    PutVarint(out, attr.fg);
+    PutVarint(out, attr.bg);
+    PutVarint(out, attr.flags);
+}
+
+namespace {
+
+struct Reader {
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+
+    bool Byte(uint8_t *value) {
+        if (position >= length) return false;
+        *value = data[position++];
+        return true;
+    }
+
+    bool Varint(uint64_t *value) {
+        *value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte;
+            if (!Byte(&byte)) return false;
+            *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool Int(int *value, int max) {
+        uint64_t raw;
+        if (!Varint(&raw) || raw > static_cast<uint64_t>(max)) return false;
+        *value = static_cast<int>(raw);
+        return true;
+    }
+
+    bool Attr(Attributes *attr) {
+        uint64_t fg, bg, flags;
+        if (!Varint(&fg) || !Varint(&bg) || !Varint(&flags)) return false;
+        if (fg > 0xFFFFFFFFu || bg > 0xFFFFFFFFu || flags > 0xFFFFu) return false;
+        attr->fg = static_cast<uint32_t>(fg);
+        attr->bg = static_cast<uint32_t>(bg);
+        attr->flags = static_cast<uint16_t>(flags);
+        return true;
+    }
+};
+
+} // namespace
+
+static bool IsBlank(const Cell &cell) {
+    return cell.codepoint == ' ' && cell.attr == Attributes{kDefaultColor, kDefaultColor, 0};
+}
+
+static int UsedCells(const std::vector<Cell> &line) {
+    int used = static_cast<int>(line.size());
+    while (used > 0 && IsBlank(line[used - 1])) {
+        used--;
+    }
+    return used;
+}
+
+static void PutLine(std::string *out, const std::vector<Cell> &line) {
+    int used = UsedCells(line);
+    PutVarint(out, used);
+    for (int x = 0; x < used;) {
+        int run = x + 1;
+        while (run < used && line[run].attr == line[x].attr) {
+            run++;
+        }
+        PutVarint(out, run - x);
+        PutAttributes(out, line[x].attr);
+        for (; x < run; x++) {
+            PutVarint(out, line[x].codepoint);
+        }
+    }
+}
+
+void Screen::Encode(std::string *out) const {
+    out->append(kMagic, sizeof(kMagic));
+    out->push_back(static_cast<char>(kVersion));
+    PutVarint(out, cols);
+    PutVarint(out, rows);
+
+    uint8_t flags = 0;
+    if (alternate) flags |= kAlternate;
+    if (cursorVisible) flags |= kCursorVisible;
+    if (autoWrap) flags |= kAutoWrap;
+    if (cursor.wrapPending) flags |= kWrapPending;
+    if (applicationCursor) flags |= kApplicationCursor;
+    if (bracketedPaste) flags |= kBracketedPaste;
+    out->push_back(static_cast<char>(flags));
+
+    PutVarint(out, cursor.x);
+    PutVarint(out, cursor.y);
+    PutAttributes(out, cursor.attr);
+    PutVarint(out, scrollTop);
+    PutVarint(out, scrollBottom);
+    PutVarint(out, title.size());
+    out->append(title);
+
+    for (const Buffer &buffer : buffers) {
+        PutVarint(out, buffer.saved.x);
+        PutVarint(out, buffer.saved.y);
+        PutAttributes(out, buffer.saved.attr);
+
+        for (const Line &line : buffer.lines) {
+            PutLine(out, line);
+        }
+    }
+}
+
+bool Screen::Decode(const char *data, size_t length) {
+    Reader reader = {reinterpret_cast<const unsigned char *>(data), length, 0};
+    if (length < sizeof(kMagic) + 1 || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    reader.position = sizeof(kMagic);
+
+    uint8_t version, flags;
+    int newCols, newRows;
+    if (!reader.Byte(&version) || version != kVersion) return false;
+    if (!reader.Int(&newCols, kMaxCells) || !reader.Int(&newRows, kMaxCells)) return false;
+    if (newCols < 1 || newRows < 1 || static_cast<long long>(newCols) * newRows > kMaxCells) return false;
+    if (!reader.Byte(&flags)) return false;
+
+    // Décodé à part : l'écran courant reste intact si l'instantané est invalide
+    Screen decoded(newCols, newRows);
+    decoded.alternate = (flags & kAlternate) != 0;
+    decoded.cursorVisible = (flags & kCursorVisible) != 0;
+    decoded.autoWrap = (flags & kAutoWrap) != 0;
+    decoded.cursor.wrapPending = (flags & kWrapPending) != 0;
+    decoded.applicationCursor = (flags & kApplicationCursor) != 0;
+    decoded.bracketedPaste = (flags & kBracketedPaste) != 0;
+
+    int titleLength;
+    if (!reader.Int(&decoded.cursor.x, newCols - 1) || !reader.Int(&decoded.cursor.y, newRows - 1) ||
+        !reader.Attr(&decoded.cursor.attr) ||
+        !reader.Int(&decoded.scrollTop, newRows - 1) || !reader.Int(&decoded.scrollBottom, newRows - 1) ||
+        decoded.scrollTop >= decoded.scrollBottom ||
+        !reader.Int(&titleLength, static_cast<int>(length - reader.position))) {
+        return false;
+    }
+    decoded.title.assign(data + reader.position, titleLength);
+    reader.position += titleLength;
+
+    for (Buffer &buffer : decoded.buffers) {
+        if (!reader.Int(&buffer.saved.x, newCols - 1) || !reader.Int(&buffer.saved.y, newRows - 1) ||
+            !reader.Attr(&buffer.saved.attr)) {
+            return false;
+        }
+
+        for (Line &line : buffer.lines) {
+            int used;
+            if (!reader.Int(&used, newCols)) return false;
+            for (int x = 0; x < used;) {
+                int run;
+                Attributes attr;
+                if (!reader.Int(&run, used - x) || run == 0 || !reader.Attr(&attr)) return false;
+                for (int end = x + run; x < end; x++) {
+                    uint64_t codepoint;
+                    if (!reader.Varint(&codepoint) || codepoint > 0x10FFFF) return false;
+                    line[x] = Cell{static_cast<uint32_t>(codepoint), attr};
+                }
+            }
+        }
+    }
+
+    *this = std::move(decoded);
+    DamageAll();
+    return true;
+}
+
+bool Screen::HasDamage() const {
+    return damaged || cursor.x != frameX || cursor.y != frameY || cursorVisible != frameCursorVisible;
+}
+
+void Screen::EncodeFrame(std::string *out) {
+    uint8_t flags = 0;
+    if (fullDamage) flags |= kFullFrame;
+    if (cursorVisible) flags |= kFrameCursorVisible;
+    if (alternate) flags |= kFrameAlternate;
+
+    int count = 0;
+    for (int y = 0; y < rows; y++) {
+        count += damage[y] ? 1 : 0;
+    }
+
+    out->push_back(static_cast<char>(kVersion));
+    out->push_back(static_cast<char>(flags));
+    PutVarint(out, cols);
+    PutVarint(out, rows);
+    PutVarint(out, cursor.x);
+    PutVarint(out, cursor.y);
+    PutVarint(out, count);
+
+    const std::vector<Line> &lines = Active().lines;
+    for (int y = 0; y < rows; y++) {
+        if (!damage[y]) continue;
+        PutVarint(out, y);
+        PutLine(out, lines[y]);
+        damage[y] = 0;
+    }
+
+    damaged = false;
+    fullDamage = false;
+    frameX = cursor.x;
+    frameY = cursor.y;
+    frameCursorVisible = cursorVisible;
+}
+
+static void AppendUtf8(std::string *out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out->push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        out->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+static void AppendColor(std::string *out, uint32_t color, int base) {
+    uint32_t value = color & 0xFFFFFF;
+    if ((color & 0xFF000000) == kPaletteColor) {
+        if (value < 8) {
+            *out += ";" + std::to_string(base + value);
+        } else if (value < 16) {
+            *out += ";" + std::to_string(base + 60 + value - 8);
+        } else {
+            *out += ";" + std::to_string(base + 8) + ";5;" + std::to_string(value);
+        }
+    } else if ((color & 0xFF000000) == kRgbColor) {
+        *out += ";" + std::to_string(base + 8) + ";2;" + std::to_string(value >> 16) + ";" +
+                std::to_string((value >> 8) & 0xFF) + ";" + std::to_string(value & 0xFF);
+    }
+}
+
+static void AppendSgr(std::string *out, const Attributes &attr) {
+    static const struct { uint16_t flag; const char *code; } kFlagCodes[] = {
+        {kBold, ";1"}, {kDim, ";2"}, {kItalic, ";3"}, {kUnderline, ";4"},
+        {kBlink, ";5"}, {kInverse, ";7"}, {kHidden, ";8"}, {kStrike, ";9"},
+    };
+
+    *out += "\x1b[0";
+    for (const auto &entry : kFlagCodes) {
+        if (attr.flags & entry.flag) {
+            *out += entry.code;
+        }
+    }
+    AppendColor(out, attr.fg, 30);
+    AppendColor(out, attr.bg, 40);
+    *out += "m";
+}
+
+std::string Screen::RenderAnsi() const {
+    std::string out;
+    out += "\x1b[0m";
+    if (alternate) {
+        out += "\x1b[?1049h";
+    }
+    out += "\x1b[H\x1b[2J";
+
+    const Attributes defaults = {kDefaultColor, kDefaultColor, 0};
+    const std::vector<Line> &lines = Active().lines;
+    for (int y = 0; y < rows; y++) {
+        const Line &line = lines[y];
+        int used = UsedCells(line);
+        if (used == 0) continue;
+
+        out += "\x1b[" + std::to_string(y + 1) + ";1H";
+        Attributes current = defaults;
+        for (int x = 0; x < used; x++) {
+            const Cell &cell = line[x];
+            if (cell.codepoint == 0) continue;
+            if (cell.attr != current) {
+                AppendSgr(&out, cell.attr);
+                current = cell.attr;
+            }
+            AppendUtf8(&out, cell.codepoint);
+        }
+        if (current != defaults) {
+            out += "\x1b[0m";
+        }
+    }
+
+    if (scrollTop != 0 || scrollBottom != rows - 1) {
+        out += "\x1b[" + std::to_string(scrollTop + 1) + ";" + std::to_string(scrollBottom + 1) + "r";
+    }
+    if (!autoWrap) out += "\x1b[?7l";
+    if (applicationCursor) out += "\x1b[?1h";
+    if (bracketedPaste) out += "\x1b[?2004h";
+    if (!cursorVisible) out += "\x1b[?25l";
+    if (!title.empty()) {
+        out += "\x1b]2;" + title + "\x07";
+    }
+
+    AppendSgr(&out, cursor.attr);
+    out += "\x1b[" + std::to_string(cursor.y + 1) + ";" + std::to_string(cursor.x + 1) + "H";
+    return out;
+}
+
+} // namespace vt
@@ -0,0 +1,161 @@
+#include "vt/triggers.h"
+#include "vt/scan.h"
+#include <algorithm>
+#include <queue>
+
+namespace vt {
+
+static unsigned char Fold(unsigned char byte) {
+    return (byte >= 'A' && byte <= 'Z') ? static_cast<unsigned char>(byte + 32) : byte;
+}
+
+TriggerSet::TriggerSet(const std::vector<Pattern> &list) : patterns(list) {
+    for (const Pattern &pattern : patterns) {
+        hasStrip = hasStrip || pattern.strip;
+    }
+    Build(&exact, false);
+    Build(&folded, true);
+
+    for (int byte = 0; byte < 256; byte++) {
+        bool leaves = (!exact.Empty() && exact.Next(0, static_cast<unsigned char>(byte)) != 0) ||
+                      (!folded.Empty() && folded.Next(0, static_cast<unsigned char>(byte)) != 0);
+        if (leaves) {
+            firstBytes.Add(static_cast<unsigned char>(byte));
+        }
+    }
+}
+
+void TriggerSet::Build(Automaton *automaton, bool fold) {
+    // Classes d'octets : ceux absents des motifs partagent la classe 0 ; en
+    // mode insensible, une majuscule prend la classe de sa minuscule
+    for (const Pattern &pattern : patterns) {
+        if (pattern.ignoreCase != fold) {
+            continue;
+        }
+        for (unsigned char c : pattern.text) {
+            unsigned char byte = fold ? Fold(c) : c;
+            if (automaton->classes[byte] == 0) {
+                automaton->classes[byte] = static_cast<uint8_t>(automaton->classCount++);
+            }
+        }
+    }
+    if (fold) {
+        for (int byte = 'A'; byte <= 'Z'; byte++) {
+            automaton->classes[byte] = automaton->classes[byte + 32];
+        }
+    }
+
+    // Trie des motifs, 0 signifiant "pas de transition" avant les liens d'échec
+    const uint32_t width = automaton->classCount;
+    std::vector<uint32_t> &delta = automaton->delta;
+    delta.assign(width, 0);
+    automaton->depths.assign(1, 0);
+    automaton->outputs.assign(1, std::vector<uint32_t>());
+    for (uint32_t index = 0; index < patterns.size(); index++) {
+        const Pattern &pattern = patterns[index];
+        if (pattern.ignoreCase != fold) {
+            continue;
+        }
+        uint32_t state = 0;
+        for (unsigned char byte : pattern.text) {
+            uint32_t slot = state * width + automaton->classes[byte];
+            if (delta[slot] == 0) {
+                delta[slot] = static_cast<uint32_t>(automaton->depths.size());
+                automaton->depths.push_back(automaton->depths[state] + 1);
+                automaton->outputs.emplace_back();
+                delta.resize(delta.size() + width, 0);
+            }
+            state = delta[slot];
+        }
+        automaton->outputs[state].push_back(index);
+    }
+
+    // Liens d'échec en largeur, transformés directement en automate complet
+    std::vector<uint32_t> fail(automaton->depths.size(), 0);
+    std::queue<uint32_t> queue;
+    for (uint32_t cls = 0; cls < width; cls++) {
+        if (delta[cls] != 0) {
+            queue.push(delta[cls]);
+        }
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop();
+        const std::vector<uint32_t> &inherited = automaton->outputs[fail[state]];
+        automaton->outputs[state].insert(automaton->outputs[state].end(), inherited.begin(), inherited.end());
+        for (uint32_t cls = 0; cls < width; cls++) {
+            uint32_t &slot = delta[state * width + cls];
+            uint32_t fallback = delta[fail[state] * width + cls];
+            if (slot != 0) {
+                fail[slot] = fallback;
+                queue.push(slot);
+            } else {
+                slot = fallback;
+            }
+        }
+    }
+
+    // Les notifications passent avant les retraits qui finissent au même endroit
+    for (std::vector<uint32_t> &found : automaton->outputs) {
+        std::stable_sort(found.begin(), found.end(),
+                         [this](uint32_t a, uint32_t b) { return !patterns[a].strip && patterns[b].strip; });
+    }
+}
+
+size_t TriggerSet::Depth(const State &state) const {
+    size_t depth = exact.Empty() ? 0 : exact.depths[state.exact];
+    if (!folded.Empty()) {
+        depth = std::max<size_t>(depth, folded.depths[state.folded]);
+    }
+    return depth;
+}
+
+void TriggerSet::Report(const Automaton &automaton, uint32_t state, size_t end, std::vector<Match> *matches,
+                        bool *reset) const {
+    for (uint32_t index : automaton.outputs[state]) {
+        const Pattern &pattern = patterns[index];
+        matches->push_back(Match{pattern.id, end, pattern.text.size(), pattern.strip, pattern.notify});
+        if (pattern.strip) {
+            // Une seule occurrence retirée par position
+            *reset = true;
+            return;
+        }
+    }
+}
+
+void TriggerSet::Scan(const char *data, size_t length, State *state, std::vector<Match> *matches) const {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    const bool useExact = !exact.Empty();
+    const bool useFolded = !folded.Empty();
+    State current = *state;
+    size_t i = 0;
+
+    while (i < length) {
+        if (current.exact == 0 && current.folded == 0) {
+            i += FindAnyOf(data + i, length - i, firstBytes);
+            if (i == length) {
+                break;
+            }
+        }
+        unsigned char byte = bytes[i++];
+        bool reset = false;
+        if (useExact) {
+            current.exact = exact.Next(current.exact, byte);
+            if (!exact.outputs[current.exact].empty()) {
+                Report(exact, current.exact, i, matches, &reset);
+            }
+        }
+        if (useFolded) {
+            current.folded = folded.Next(current.folded, byte);
+            if (!reset && !folded.outputs[current.folded].empty()) {
+                Report(folded, current.folded, i, matches, &reset);
+            }
+        }
+        if (reset) {
+            current = State();
+        }
+    }
+    *state = current;
+}
+
+} // namespace vt
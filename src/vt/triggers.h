@@ -0,0 +1,78 @@
+#pragma once
+#include "vt/scan.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vt {
+
+// Motifs littéraux compilés en automates d'Aho-Corasick (un pour les motifs
+// exacts, un pour ceux insensibles à la casse) : un seul passage sur la
+// sortie, quel que soit le nombre de motifs. L'état est conservé par
+// l'appelant, les occurrences à cheval sur deux morceaux sont donc trouvées.
+class TriggerSet {
+public:
+    struct Pattern {
+        uint32_t id;
+        std::string text;
+        bool ignoreCase; // ASCII seulement
+        bool strip;      // retirer l'occurrence du flux
+        bool notify;     // l'appelant veut être prévenu
+    };
+
+    struct Match {
+        uint32_t id;
+        size_t end; // position après le dernier octet, relative au morceau
+        size_t length;
+        bool strip;
+        bool notify;
+    };
+
+    // Position dans chacun des deux automates, {0, 0} au départ
+    struct State {
+        uint32_t exact = 0;
+        uint32_t folded = 0;
+    };
+
+    explicit TriggerSet(const std::vector<Pattern> &patterns);
+
+    bool HasStrip() const { return hasStrip; }
+
+    // Reprend depuis *state ; les occurrences sont ajoutées à matches par
+    // position de fin croissante. Après une occurrence à retirer, les
+    // automates repartent de zéro.
+    void Scan(const char *data, size_t length, State *state, std::vector<Match> *matches) const;
+
+    // Longueur du début de motif reconnu : ce qu'il faut retenir pour pouvoir
+    // encore retirer une occurrence à cheval
+    size_t Depth(const State &state) const;
+
+private:
+    struct Automaton {
+        uint8_t classes[256] = {};
+        uint32_t classCount = 1;
+        std::vector<uint32_t> delta;
+        std::vector<uint32_t> depths;
+        // Motifs reconnus dans chaque état, suffixes compris
+        std::vector<std::vector<uint32_t>> outputs;
+
+        bool Empty() const { return depths.size() <= 1; }
+        uint32_t Next(uint32_t state, unsigned char byte) const {
+            return delta[state * classCount + classes[byte]];
+        }
+    };
+
+    void Build(Automaton *automaton, bool fold);
+    void Report(const Automaton &automaton, uint32_t state, size_t end, std::vector<Match> *matches,
+                bool *reset) const;
+
+    Automaton exact;
+    Automaton folded;
+    std::vector<Pattern> patterns;
+    bool hasStrip = false;
+    // Octets qui font quitter la racine, pour sauter le reste au préfiltre
+    ByteSet firstBytes;
+};
+
+} // namespace vt
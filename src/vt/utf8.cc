@@ -0,0 +1,81 @@
+#include "vt/utf8.h"
+#include "vt/scan.h"
+
+namespace vt {
+
+// Longueur de la séquence valide commençant en data[0], 0 si invalide
+static size_t SequenceLength(const unsigned char *data, size_t length) {
+    unsigned char lead = data[0];
+    size_t need;
+    unsigned char min = 0x80, max = 0xBF;
+
+    if (lead < 0x80) {
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        need = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        need = 3;
+        if (lead == 0xE0) min = 0xA0;
+        if (lead == 0xED) max = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        need = 4;
+        if (lead == 0xF0) min = 0x90;
+        if (lead == 0xF4) max = 0x8F;
+    } else {
+        return 0;
+    }
+
+    if (length < need || data[1] < min || data[1] > max) {
+        return 0;
+    }
+    for (size_t i = 2; i < need; i++) {
+        if ((data[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return need;
+}
+
+Utf8Check ValidateUtf8(const char *data, size_t length) {
+    Utf8Check check = {true, true};
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    size_t i = 0;
+    while (i < length) {
+        i += AsciiRun(data + i, length - i);
+        if (i == length) break;
+
+        check.ascii = false;
+        size_t sequence = SequenceLength(bytes + i, length - i);
+        if (sequence == 0) {
+            check.valid = false;
+            return check;
+        }
+        i += sequence;
+    }
+    return check;
+}
+
+void AppendSanitizedUtf8(const char *data, size_t length, std::string *out) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    out->reserve(out->size() + length);
+
+    size_t i = 0;
+    while (i < length) {
+        size_t run = AsciiRun(data + i, length - i);
+        out->append(data + i, run);
+        i += run;
+        if (i == length) break;
+
+        size_t sequence = SequenceLength(bytes + i, length - i);
+        if (sequence == 0) {
+            out->append("\xEF\xBF\xBD");
+            i++;
+        } else {
+            out->append(data + i, sequence);
+            i += sequence;
+        }
+    }
+}
+
+} // namespace vt
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace vt {
+
+struct Utf8Check {
+    bool valid;
+    bool ascii;
+};
+
+// Validation stricte (ni surlongueur, ni surrogates, ni > U+10FFFF). Les
+// plages ASCII sont sautées par blocs via AsciiRun().
+Utf8Check ValidateUtf8(const char *data, size_t length);
+
+// Copie data dans out en remplaçant chaque octet invalide par U+FFFD
+void AppendSanitizedUtf8(const char *data, size_t length, std::string *out);
+
+} // namespace vt
@@ -1,9 +1,31 @@
 #include "win/conpty.h"
-#include <iostream>
+#include "Logger/logger.h"
 #include <vector>
 
 namespace conpty {
 
+// Points d'entrée ConPTY, cherchés une seule fois : kernel32 est toujours
+// chargé, inutile de repasser par LoadLibrary à chaque resize()
+struct PseudoConsoleApi {
+    HRESULT (WINAPI *create)(COORD size, HANDLE input, HANDLE output, DWORD flags, HPCON *console);
+    HRESULT (WINAPI *resize)(HPCON console, COORD size);
+    void (WINAPI *close)(HPCON console);
+};
+
+static const PseudoConsoleApi &Api() {
+    static const PseudoConsoleApi api = []() {
+        PseudoConsoleApi resolved = {};
+        HMODULE kernel = GetModuleHandleW(L"kernel32.dll");
+        if (kernel) {
+            resolved.create = reinterpret_cast<decltype(resolved.create)>(GetProcAddress(kernel, "CreatePseudoConsole"));
+            resolved.resize = reinterpret_cast<decltype(resolved.resize)>(GetProcAddress(kernel, "ResizePseudoConsole"));
+            resolved.close = reinterpret_cast<decltype(resolved.close)>(GetProcAddress(kernel, "ClosePseudoConsole"));
+        }
+        return resolved;
+    }();
+    return api;
+}
+
 ConPTY::ConPTY() 
     : hPipeIn(INVALID_HANDLE_VALUE)
     , hPipeOut(INVALID_HANDLE_VALUE)
@@ -13,6 +35,8 @@ ConPTY::ConPTY()
     , hProcess(INVALID_HANDLE_VALUE)
     , hThread(INVALID_HANDLE_VALUE)
     , processId(0)
+    , exitWait(nullptr)
+    , exitListener(nullptr)
     , isInitialized(false) {
 }
 
@@ -29,14 +53,14 @@ bool ConPTY::CreatePipes() {
     
     // Créer des pipes anonymes
     if (!CreatePipe(&hPtyIn, &hPipeIn, &sa, 0)) {
-        std::cerr << "Failed to create input pipe: " << GetLastError() << std::endl;
+        LOG_ERROR("Failed to create input pipe: " << GetLastError());
         return false;
     }
 
     if (!CreatePipe(&hPipeOut, &hPtyOut, &sa, 0)) {
         CloseHandle(hPtyIn);
         CloseHandle(hPipeIn);
-        std::cerr << "Failed to create output pipe: " << GetLastError() << std::endl;
+        LOG_ERROR("Failed to create output pipe: " << GetLastError());
         return false;
     }
 
@@ -69,35 +93,84 @@ bool ConPTY::Create(SHORT cols, SHORT rows) {
 }
 
 bool ConPTY::CreatePseudoConsole(SHORT cols, SHORT rows) {
-    HMODULE hLibrary = LoadLibraryExW(L"kernel32.dll", nullptr, 0);
-    if (!hLibrary) {
+    const PseudoConsoleApi &api = Api();
+    if (!api.create) {
         return false;
     }
 
-    typedef HRESULT (*PFNCREATEPSEUDOCONSOLE)(COORD c, HANDLE hIn, HANDLE hOut, DWORD dwFlags, HPCON* phpcon);
-    auto pfnCreatePseudoConsole = reinterpret_cast<PFNCREATEPSEUDOCONSOLE>(
-        GetProcAddress(hLibrary, "CreatePseudoConsole"));
+    COORD size = { cols, rows };
+    HRESULT hr = api.create(size, hPtyIn, hPtyOut, 0, &hPC);
+    return SUCCEEDED(hr);
+}
 
-    if (!pfnCreatePseudoConsole) {
-        FreeLibrary(hLibrary);
-        return false;
+// UTF-8 -> UTF-16 sur toute la longueur, zéros intermédiaires compris
+static std::wstring Widen(const std::string& text) {
+    if (text.empty()) {
+        return std::wstring();
     }
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    if (length <= 0) {
+        return std::wstring();
+    }
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], length);
+    return wide;
+}
 
-    COORD size = { cols, rows };
-    HRESULT hr = pfnCreatePseudoConsole(size, hPtyIn, hPtyOut, 0, &hPC);
-    
-    FreeLibrary(hLibrary);
+// Guillemets selon les règles de CommandLineToArgvW
+static void AppendArgument(std::wstring& line, const std::wstring& arg) {
+    if (!line.empty()) {
+        line += L' ';
+    }
+    if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) {
+        line += arg;
+        return;
+    }
 
-    return SUCCEEDED(hr);
+    line += L'"';
+    size_t backslashes = 0;
+    for (wchar_t c : arg) {
+        if (c == L'\\') {
+            backslashes++;
+            continue;
+        }
+        // Les \ qui précèdent un " sont doublés, le " est échappé
+        line.append(c == L'"' ? backslashes * 2 + 1 : backslashes, L'\\');
+        backslashes = 0;
+        line += c;
+    }
+    line.append(backslashes * 2, L'\\');
+    line += L'"';
 }
-bool ConPTY::Start(const std::wstring& command) {
+
+bool ConPTY::Start(const backend::SpawnOptions& options) {
     if (!isInitialized) {
         return false;
     }
 
-    // Changer STARTUPINFOEX en STARTUPINFOEXW pour utiliser la version Wide
+    // Sans argument, file est une ligne de commande complète ("powershell.exe -NoLogo")
+    std::wstring commandLine = Widen(options.file);
+    if (!options.args.empty()) {
+        commandLine.clear();
+        AppendArgument(commandLine, Widen(options.file));
+        for (const std::string& arg : options.args) {
+            AppendArgument(commandLine, Widen(arg));
+        }
+    }
+    if (commandLine.empty()) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+    // CreateProcessW peut modifier la ligne de commande
+    std::vector<wchar_t> cmdline(commandLine.begin(), commandLine.end());
+    cmdline.push_back(L'\0');
+
+    // Le bloc d'environnement se convertit d'un seul tenant
+    std::wstring environment = Widen(options.environment);
+    std::wstring cwd = Widen(options.cwd);
+
     STARTUPINFOEXW siEx = { 0 };
-    siEx.StartupInfo.cb = sizeof(STARTUPINFOEXW);  // Mettre à jour la taille
+    siEx.StartupInfo.cb = sizeof(STARTUPINFOEXW);
 
     SIZE_T size;
     InitializeProcThreadAttributeList(nullptr, 1, 0, &size);
@@ -105,6 +178,7 @@ bool ConPTY::Start(const std::wstring& command) {
         GetProcessHeap(), 0, size);
 
     if (!InitializeProcThreadAttributeList(siEx.lpAttributeList, 1, 0, &size)) {
+        HeapFree(GetProcessHeap(), 0, siEx.lpAttributeList);
         return false;
     }
 
@@ -116,25 +190,24 @@ bool ConPTY::Start(const std::wstring& command) {
         sizeof(HPCON),
         nullptr,
         nullptr)) {
+        DeleteProcThreadAttributeList(siEx.lpAttributeList);
         HeapFree(GetProcessHeap(), 0, siEx.lpAttributeList);
         return false;
     }
 
     PROCESS_INFORMATION pi = { 0 };
-    WCHAR cmdline[MAX_PATH];
-    wcscpy_s(cmdline, command.c_str());
-
     BOOL success = CreateProcessW(
         nullptr,
-        cmdline,
+        cmdline.data(),
         nullptr,
         nullptr,
         FALSE,
-        EXTENDED_STARTUPINFO_PRESENT,
-        nullptr,
-        nullptr,
+        EXTENDED_STARTUPINFO_PRESENT | CREATE_UNICODE_ENVIRONMENT,
+        environment.empty() ? nullptr : &environment[0],
+        cwd.empty() ? nullptr : cwd.c_str(),
         &siEx.StartupInfo,
         &pi);
+    DWORD error = GetLastError();
 
     if (success) {
         hProcess = pi.hProcess;
@@ -142,60 +215,136 @@ bool ConPTY::Start(const std::wstring& command) {
         processId = pi.dwProcessId;
     }
 
+    DeleteProcThreadAttributeList(siEx.lpAttributeList);
     HeapFree(GetProcessHeap(), 0, siEx.lpAttributeList);
+    SetLastError(error);
     return success ? true : false;
 }
 
-bool ConPTY::Write(const char* data, DWORD length, DWORD* written) {
+bool ConPTY::Write(const char* data, uint32_t length, uint32_t* written) {
     if (!isInitialized || hPipeIn == INVALID_HANDLE_VALUE) {
         return false;
     }
 
-    return WriteFile(hPipeIn, data, length, written, nullptr);
+    DWORD bytes = 0;
+    BOOL success = WriteFile(hPipeIn, data, length, &bytes, nullptr);
+    *written = bytes;
+    return success ? true : false;
+}
+
+bool ConPTY::TryWrite(const char* data, uint32_t length, uint32_t* written) {
+    // Les tubes anonymes ne savent pas écrire sans bloquer : le terminal
+    // n'appelle TryWrite() que pour les backends surveillés par le réacteur.
+    return Write(data, length, written);
 }
 
-bool ConPTY::Read(char* data, DWORD length, DWORD* read) {
+bool ConPTY::Read(char* data, uint32_t length, uint32_t* read) {
     if (!isInitialized || hPipeOut == INVALID_HANDLE_VALUE) {
         return false;
     }
 
-    return ReadFile(hPipeOut, data, length, read, nullptr);
+    DWORD bytes = 0;
+    BOOL success = ReadFile(hPipeOut, data, length, &bytes, nullptr);
+    *read = bytes;
+    return success ? true : false;
 }
 
-bool ConPTY::Resize(SHORT cols, SHORT rows) {
-    if (!isInitialized) return false;
+bool ConPTY::TryRead(char* data, uint32_t length, uint32_t* read) {
+    *read = 0;
+    if (!isInitialized || hPipeOut == INVALID_HANDLE_VALUE) {
+        return false;
+    }
 
-    HMODULE hLibrary = LoadLibraryExW(L"kernel32.dll", nullptr, 0);
-    if (!hLibrary) return false;
+    DWORD available = 0;
+    if (!PeekNamedPipe(hPipeOut, nullptr, 0, nullptr, &available, nullptr)) {
+        return false;
+    }
+    if (available == 0) {
+        SetLastError(ERROR_NO_DATA);
+        return false;
+    }
+    return Read(data, available < length ? available : length, read);
+}
+
+uint32_t ConPTY::BytesAvailable() {
+    if (!isInitialized || hPipeOut == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+
+    DWORD available = 0;
+    if (!PeekNamedPipe(hPipeOut, nullptr, 0, nullptr, &available, nullptr)) {
+        return 0;
+    }
+    return available;
+}
 
-    typedef HRESULT (*PFNRESIZEPSEUDOCONSOLE)(HPCON hPC, COORD size);
-    auto pfnResizePseudoConsole = reinterpret_cast<PFNRESIZEPSEUDOCONSOLE>(
-        GetProcAddress(hLibrary, "ResizePseudoConsole"));
+bool ConPTY::Resize(SHORT cols, SHORT rows) {
+    if (!isInitialized) return false;
 
-    if (!pfnResizePseudoConsole) {
-        FreeLibrary(hLibrary);
+    const PseudoConsoleApi &api = Api();
+    if (!api.resize) {
         return false;
     }
 
     COORD size = { cols, rows };
-    HRESULT hr = pfnResizePseudoConsole(hPC, size);
-    
-    FreeLibrary(hLibrary);
+    HRESULT hr = api.resize(hPC, size);
     return SUCCEEDED(hr);
 }
 
+void ConPTY::CancelIo() {
+    // Interrompt un ReadFile/WriteFile synchrone en cours sur un autre thread
+    if (hPipeOut != INVALID_HANDLE_VALUE) {
+        CancelIoEx(hPipeOut, nullptr);
+    }
+    if (hPipeIn != INVALID_HANDLE_VALUE) {
+        CancelIoEx(hPipeIn, nullptr);
+    }
+}
+
+bool ConPTY::HasExited() {
+    if (hProcess == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    return WaitForSingleObject(hProcess, 0) == WAIT_OBJECT_0;
+}
+
+VOID CALLBACK ConPTY::OnProcessSignaled(PVOID context, BOOLEAN) {
+    ConPTY *pty = static_cast<ConPTY *>(context);
+    DWORD code = 0;
+    GetExitCodeProcess(pty->hProcess, &code);
+    pty->exitListener->OnProcessExit(static_cast<int>(code), 0);
+}
+
+bool ConPTY::WatchExit(backend::ExitListener *listener) {
+    if (hProcess == INVALID_HANDLE_VALUE || exitWait) {
+        return false;
+    }
+    exitListener = listener;
+    // Pas de thread à nous : le pool de Windows attend le handle
+    if (!RegisterWaitForSingleObject(&exitWait, hProcess, OnProcessSignaled, this, INFINITE, WT_EXECUTEONLYONCE)) {
+        LOG_WARNING("RegisterWaitForSingleObject failed: " << GetLastError());
+        exitWait = nullptr;
+        exitListener = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void ConPTY::UnwatchExit() {
+    if (exitWait) {
+        // INVALID_HANDLE_VALUE : attend la fin d'un rappel en cours
+        UnregisterWaitEx(exitWait, INVALID_HANDLE_VALUE);
+        exitWait = nullptr;
+        exitListener = nullptr;
+    }
+}
+
 void ConPTY::Close() {
+    UnwatchExit();
     if (hPC != nullptr) {
-        HMODULE hLibrary = LoadLibraryExW(L"kernel32.dll", nullptr, 0);
-        if (hLibrary) {
-            typedef void (*PFNCLOSEPSEUDOCONSOLE)(HPCON hPC);
-            auto pfnClosePseudoConsole = reinterpret_cast<PFNCLOSEPSEUDOCONSOLE>(
-                GetProcAddress(hLibrary, "ClosePseudoConsole"));
-            
-            if (pfnClosePseudoConsole) {
-                pfnClosePseudoConsole(hPC);
-            }
-            FreeLibrary(hLibrary);
+        const PseudoConsoleApi &api = Api();
+        if (api.close) {
+            api.close(hPC);
         }
         hPC = nullptr;
     }
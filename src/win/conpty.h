@@ -1,5 +1,6 @@
 #pragma once
 
+#include "pty_backend.h"
 #include <Windows.h>
 #include <string>
 
@@ -12,21 +13,30 @@ typedef void *HPCON;
 
 namespace conpty {
 
-class ConPTY {
+class ConPTY : public backend::PtyBackend {
 public:
     ConPTY();
     ~ConPTY();
 
-    bool Create(SHORT cols, SHORT rows);
-    bool Start(const std::wstring &command);
-    bool Write(const char *data, DWORD length, DWORD *written);
-    bool Read(char *data, DWORD length, DWORD *read);
-    bool Resize(SHORT cols, SHORT rows);
-    void Close();
-    bool IsActive() const;
-    DWORD GetProcessId() const { return processId; }
+    bool Create(SHORT cols, SHORT rows) override;
+    bool Start(const backend::SpawnOptions &options) override;
+    bool Write(const char *data, uint32_t length, uint32_t *written) override;
+    bool TryWrite(const char *data, uint32_t length, uint32_t *written) override;
+    bool Read(char *data, uint32_t length, uint32_t *read) override;
+    bool TryRead(char *data, uint32_t length, uint32_t *read) override;
+    bool Resize(SHORT cols, SHORT rows) override;
+    void Close() override;
+    bool IsActive() const override;
+    bool HasExited() override;
+    uint32_t GetProcessId() const override { return processId; }
+    uint32_t BytesAvailable() override;
+    void CancelIo() override;
+    bool WatchExit(backend::ExitListener *listener) override;
+    void UnwatchExit() override;
 
 private:
+    static VOID CALLBACK OnProcessSignaled(PVOID context, BOOLEAN timedOut);
+
     bool CreatePipes();
     bool CreatePseudoConsole(SHORT cols, SHORT rows);
 
@@ -38,6 +48,9 @@ private:
     HANDLE hProcess;
     HANDLE hThread;
     DWORD processId;
+    // Attente du pool de threads Windows sur hProcess (WatchExit)
+    HANDLE exitWait;
+    backend::ExitListener *exitListener;
     bool isInitialized;
 };
 
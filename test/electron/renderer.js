@@ -70,7 +70,8 @@ const startPTY = () => {
     };
 
     try {
-        ptyProcess.startProcess(ptyOptions);
+        ptyProcess.startProcess(ptyOptions)
+            .catch(error => console.error('Erreur au démarrage:', error));
 
         // Gestion des données
        term.onData(data => {
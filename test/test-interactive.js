@@ -11,7 +11,7 @@ async function main() {
 
     try {
         // Démarrer le terminal
-        const pid = term.startProcess({ 
+        const pid = await term.startProcess({ 
             cols: 120, 
             rows: 30 
         });